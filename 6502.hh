@@ -97,6 +97,9 @@ struct OpInfo
     Mnem mnemonic;
     Am addressing_mode;
     std::uint8_t flags;
+
+    // base cycle count, not including page crossing or branch penalties
+    std::uint8_t cycles;
 };
 
 struct Instr
@@ -115,6 +118,7 @@ private:
 
 OpInfo const* find_opcode_info(byte_type opcode);
 std::size_t get_addressing_mode_operand_size(Am am);
+unsigned get_max_cycles(OpInfo const& info);
 
 OpInfo const* get_instr_info(Instr const& instr);
 OpInfo const* get_instr_info(Instr const& instr, OpInfoCache const& cache);
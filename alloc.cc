@@ -0,0 +1,160 @@
+
+#include "alloc.hh"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+
+namespace
+{
+
+std::atomic<std::uint64_t> g_allocations { 0 };
+std::atomic<std::uint64_t> g_bytes { 0 };
+std::atomic<std::uint64_t> g_live_bytes { 0 };
+std::atomic<std::uint64_t> g_peak_live_bytes { 0 };
+
+}
+
+#ifdef JULIAN_ALLOC_STATS
+
+namespace
+{
+
+// each block is preceded by its size, in as much room as keeps malloc's alignment
+constexpr std::size_t HEADER_SIZE = alignof(std::max_align_t);
+
+void* counted_alloc(std::size_t size)
+{
+    void* const block = std::malloc(HEADER_SIZE + size);
+
+    if (block == nullptr)
+        return nullptr;
+
+    *static_cast<std::size_t*>(block) = size;
+
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_bytes.fetch_add(size, std::memory_order_relaxed);
+
+    std::uint64_t const live = g_live_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+    std::uint64_t peak = g_peak_live_bytes.load(std::memory_order_relaxed);
+
+    while (live > peak && !g_peak_live_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+        ;
+
+    return static_cast<char*>(block) + HEADER_SIZE;
+}
+
+void counted_free(void* ptr)
+{
+    if (ptr == nullptr)
+        return;
+
+    void* const block = static_cast<char*>(ptr) - HEADER_SIZE;
+
+    g_live_bytes.fetch_sub(*static_cast<std::size_t*>(block), std::memory_order_relaxed);
+    std::free(block);
+}
+
+void* counted_new(std::size_t size)
+{
+    if (void* const result = counted_alloc(size))
+        return result;
+
+    throw std::bad_alloc();
+}
+
+}
+
+void* operator new(std::size_t size) { return counted_new(size); }
+void* operator new[](std::size_t size) { return counted_new(size); }
+void* operator new(std::size_t size, std::nothrow_t const&) noexcept { return counted_alloc(size); }
+void* operator new[](std::size_t size, std::nothrow_t const&) noexcept { return counted_alloc(size); }
+
+void operator delete(void* ptr) noexcept { counted_free(ptr); }
+void operator delete[](void* ptr) noexcept { counted_free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { counted_free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { counted_free(ptr); }
+void operator delete(void* ptr, std::nothrow_t const&) noexcept { counted_free(ptr); }
+void operator delete[](void* ptr, std::nothrow_t const&) noexcept { counted_free(ptr); }
+
+bool alloc_counting()
+{
+    return true;
+}
+
+#else
+
+bool alloc_counting()
+{
+    return false;
+}
+
+#endif
+
+AllocCounters alloc_counters()
+{
+    return { g_allocations.load(), g_bytes.load(), g_live_bytes.load(), g_peak_live_bytes.load() };
+}
+
+void reset_alloc_peak()
+{
+    g_peak_live_bytes.store(g_live_bytes.load());
+}
+
+void AllocPhases::start(std::string name)
+{
+    stop();
+
+    reset_alloc_peak();
+    m_start = alloc_counters();
+
+    m_phases.push_back({ std::move(name), 0, 0, m_start.live_bytes, 0 });
+    m_running = true;
+}
+
+void AllocPhases::stop()
+{
+    if (!m_running)
+        return;
+
+    AllocCounters const end = alloc_counters();
+    Phase& phase = m_phases.back();
+
+    phase.allocations = end.allocations - m_start.allocations;
+    phase.bytes = end.bytes - m_start.bytes;
+    phase.peak_live_bytes = end.peak_live_bytes;
+
+    m_running = false;
+}
+
+void AllocPhases::print_table(std::ostream& output) const
+{
+    output << std::left << std::setw(12) << "phase" << std::right
+        << std::setw(14) << "allocations" << std::setw(16) << "bytes"
+        << std::setw(16) << "live at start" << std::setw(16) << "peak live" << std::endl;
+
+    for (Phase const& phase : m_phases)
+    {
+        output << std::left << std::setw(12) << phase.name << std::right
+            << std::setw(14) << phase.allocations << std::setw(16) << phase.bytes
+            << std::setw(16) << phase.live_bytes << std::setw(16) << phase.peak_live_bytes << std::endl;
+    }
+}
+
+void AllocPhases::print_json(std::ostream& output) const
+{
+    output << "{\"phases\":[";
+
+    for (std::size_t i = 0; i < m_phases.size(); ++i)
+    {
+        Phase const& phase = m_phases[i];
+
+        output << (i == 0 ? "" : ",") << "{\"name\":\"" << phase.name << "\",\"allocations\":" << phase.allocations
+            << ",\"bytes\":" << phase.bytes << ",\"live_bytes\":" << phase.live_bytes
+            << ",\"peak_live_bytes\":" << phase.peak_live_bytes << "}";
+    }
+
+    output << "]}" << std::endl;
+}
@@ -0,0 +1,50 @@
+
+#pragma once
+
+#include "common.hh"
+
+#include <ostream>
+
+// Built with JULIAN_ALLOC_STATS (make ALLOC_STATS=1), alloc.cc replaces the global allocator with one counting
+// allocations. Otherwise counters stay at 0.
+
+struct AllocCounters
+{
+    std::uint64_t allocations;
+    std::uint64_t bytes;
+    std::uint64_t live_bytes;
+
+    // since the last reset_alloc_peak
+    std::uint64_t peak_live_bytes;
+};
+
+bool alloc_counting();
+AllocCounters alloc_counters();
+void reset_alloc_peak();
+
+// Allocation statistics of the phases of a run, each lasting until the next one starts
+struct AllocPhases
+{
+    void start(std::string name);
+    void stop();
+
+    void print_table(std::ostream& output) const;
+    void print_json(std::ostream& output) const;
+
+private:
+    struct Phase
+    {
+        std::string name;
+
+        std::uint64_t allocations;
+        std::uint64_t bytes;
+
+        // at the start and the highest during the phase
+        std::uint64_t live_bytes;
+        std::uint64_t peak_live_bytes;
+    };
+
+    std::vector<Phase> m_phases;
+    AllocCounters m_start {};
+    bool m_running = false;
+};
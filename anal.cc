@@ -1,9 +1,10 @@
 
 #include "anal.hh"
+#include "constprop.hh"
+#include "pointers.hh"
 
-#include <set>
-
-#include <iostream> // FIXME: remove this and use a Log class instead
+#include <array>
+#include <optional>
 
 static bool is_valid_jump_target(AnalConfig const& anal, std::uint32_t address)
 {
@@ -68,11 +69,50 @@ static bool is_valid_write_target(AnalConfig const& anal, std::uint32_t address)
     return false;
 }
 
-static std::optional<AddressBlock> scan_code(AnalConfig const& anal, AddressBlock const& range)
+// `known_points`: anal.code_points, and the indirect targets resolved so far (sorted)
+static bool contains_known_code(std::vector<std::uint32_t> const& known_points, AddressBlock const& block)
+{
+    auto const it = std::lower_bound(known_points.begin(), known_points.end(), block.start);
+    return it != known_points.end() && block.contains(*it);
+}
+
+// What kind of target ("jump", "write" or "read") the operand of an instruction is not valid as, if any
+static char const* find_bad_operand_target(AnalConfig const& anal, OpInfo const& info, std::uint32_t operand)
+{
+    switch (info.addressing_mode)
+    {
+
+    case Am::ZRP:
+    case Am::ZRX:
+    case Am::ZRY:
+    case Am::ABS:
+    case Am::ABX:
+    case Am::ABY:
+    case Am::REL:
+        if (info.flags & OpInfo::FLAG_JUMP)
+            return is_valid_jump_target(anal, operand) ? nullptr : "jump";
+
+        [[fallthrough]];
+
+    case Am::INX:
+    case Am::INY:
+    case Am::IAB:
+        if (info.flags & OpInfo::FLAG_WRITE)
+            return is_valid_write_target(anal, operand) ? nullptr : "write";
+
+        return is_valid_read_target(anal, operand) ? nullptr : "read";
+
+    default:
+        return nullptr;
+
+    }
+}
+
+std::optional<AddressBlock> scan_code(AnalConfig const& anal, AddressBlock const& range)
 {
     SpanScanner bytes = anal.main_block.bytes(range);
 
-    std::cerr << "Scanning code at " << hex_string<4>(range.start) << std::endl;
+    anal.log << "Scanning code at " << hex_string<4>(range.start) << std::endl;
 
     while (bytes.tell() < bytes.last())
     {
@@ -85,7 +125,7 @@ static std::optional<AddressBlock> scan_code(AnalConfig const& anal, AddressBloc
         {
             // Illegal instruction: block isn't valid
 
-            std::cerr << "Invalidated " << hex_string<4>(range.start) << ": " << hex_string<4>(addr) << " is not an instruction." << std::endl;
+            anal.log << "Invalidated " << hex_string<4>(range.start) << ": " << hex_string<4>(addr) << " is not an instruction." << std::endl;
 
             return {};
         }
@@ -94,64 +134,18 @@ static std::optional<AddressBlock> scan_code(AnalConfig const& anal, AddressBloc
         {
             // We assume BRKs are invalid
 
-            std::cerr << "Invalidated " << hex_string<4>(range.start) << ": BRK is not allowed." << std::endl;
+            anal.log << "Invalidated " << hex_string<4>(range.start) << ": BRK is not allowed." << std::endl;
 
             return {};
         }
 
         Instr const instr = decode_instr_operand(addr, opcode, bytes);
 
-        switch (info->addressing_mode)
+        if (char const* const bad_target = find_bad_operand_target(anal, *info, instr.operand))
         {
+            anal.log << "Invalidated " << hex_string<4>(range.start) << ": " << hex_string<4>(instr.operand) << " is bad " << bad_target << " target." << std::endl;
 
-        case Am::ZRP:
-        case Am::ZRX:
-        case Am::ZRY:
-        case Am::ABS:
-        case Am::ABX:
-        case Am::ABY:
-        case Am::REL:
-            if (info->flags & OpInfo::FLAG_JUMP)
-            {
-                if (!is_valid_jump_target(anal, instr.operand))
-                {
-                    std::cerr << "Invalidated " << hex_string<4>(range.start) << ": " << hex_string<4>(instr.operand) << " is bad jump target." << std::endl;
-
-                    return {};
-                }
-
-                break;
-            }
-
-            [[fallthrough]];
-
-        case Am::INX:
-        case Am::INY:
-        case Am::IAB:
-            if (info->flags & OpInfo::FLAG_WRITE)
-            {
-                if (!is_valid_write_target(anal, instr.operand))
-                {
-                    std::cerr << "Invalidated " << hex_string<4>(range.start) << ": " << hex_string<4>(instr.operand) << " is bad write target." << std::endl;
-
-                    return {};
-                }
-            }
-            else
-            {
-                if (!is_valid_read_target(anal, instr.operand))
-                {
-                    std::cerr << "Invalidated " << hex_string<4>(range.start) << ": " << hex_string<4>(instr.operand) << " is bad read target." << std::endl;
-
-                    return {};
-                }
-            }
-
-            break;
-
-        default:
-            break;
-
+            return {};
         }
 
         if (info->flags & OpInfo::FLAG_JUMP)
@@ -160,14 +154,36 @@ static std::optional<AddressBlock> scan_code(AnalConfig const& anal, AddressBloc
         }
     }
 
-    std::cerr << "Invalidated " << hex_string<4>(range.start) << ": reached end of analysis range." << std::endl;
+    anal.log << "Invalidated " << hex_string<4>(range.start) << ": reached end of analysis range." << std::endl;
 
     return {};
 }
 
-static std::vector<std::uint32_t> list_code_points(AnalConfig const& anal, std::vector<AddressBlock> const& blocks)
+// Buffers reused by the iterations of one analysis, so that they allocate once rather than once per round
+struct AnalScratch
+{
+    std::vector<std::uint32_t> points;
+    std::vector<AddressBlock> ranges;
+    std::vector<AddressBlock> new_blocks;
+    std::vector<AddressBlock> merged_blocks;
+
+    // indexed by offset in the main block
+    std::vector<bool> scanned;
+    std::vector<bool> analysed;
+
+    // anal.code_points and the indirect targets resolved (sorted)
+    std::vector<std::uint32_t> known_points;
+    std::vector<std::uint32_t> merged_points;
+
+    // linear scan prefilter
+    std::vector<std::uint8_t> likelihoods;
+    std::uint32_t linear_bytes = 0;
+    std::uint32_t skipped_bytes = 0;
+};
+
+static void list_code_points(AnalConfig const& anal, std::vector<AddressBlock> const& blocks, std::vector<std::uint32_t>& result)
 {
-    std::vector<std::uint32_t> result;
+    result.clear();
 
     for (AddressBlock const& block : blocks)
     {
@@ -176,13 +192,11 @@ static std::vector<std::uint32_t> list_code_points(AnalConfig const& anal, std::
             result.push_back(addr);
         });
     }
-
-    return result;
 }
 
-static std::vector<std::uint32_t> list_code_xrefs(AnalConfig const& anal, std::vector<AddressBlock> const& blocks)
+void list_code_xrefs(AnalConfig const& anal, std::vector<AddressBlock> const& blocks, std::vector<std::uint32_t>& result)
 {
-    std::vector<std::uint32_t> result;
+    result.clear();
 
     for (AddressBlock const& block : blocks)
     {
@@ -190,7 +204,7 @@ static std::vector<std::uint32_t> list_code_xrefs(AnalConfig const& anal, std::v
         {
             OpInfo const* info = get_instr_info(instr, anal);
 
-            if (info->flags & OpInfo::FLAG_JUMP)
+            if (info != nullptr && (info->flags & OpInfo::FLAG_JUMP))
             {
                 switch (info->addressing_mode)
                 {
@@ -207,14 +221,49 @@ static std::vector<std::uint32_t> list_code_xrefs(AnalConfig const& anal, std::v
             }
         });
     }
+}
 
-    return result;
+// operands of the absolute reads of `blocks` (sorted): where tables are
+static void list_data_reads(AnalConfig const& anal, std::vector<AddressBlock> const& blocks, std::vector<std::uint32_t>& result)
+{
+    result.clear();
+
+    for (AddressBlock const& block : blocks)
+    {
+        for_each_instr(anal.main_block.bytes(block), block, [&] ([[maybe_unused]] std::uint32_t addr, Instr const& instr)
+        {
+            OpInfo const* info = get_instr_info(instr, anal);
+
+            if (info->flags & (OpInfo::FLAG_JUMP | OpInfo::FLAG_WRITE))
+                return;
+
+            switch (info->addressing_mode)
+            {
+
+            case Am::ABS:
+            case Am::ABX:
+            case Am::ABY:
+                result.push_back(instr.operand);
+                break;
+
+            default:
+                break;
+
+            }
+        });
+    }
+
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
 }
 
-static std::vector<AddressBlock> scan_code_at_points(AnalConfig const& anal, std::vector<AddressBlock> const& ranges, std::vector<std::uint32_t> const& scan_points)
+static void scan_code_at_points(AnalConfig const& anal, std::vector<AddressBlock> const& ranges, std::vector<std::uint32_t> const& scan_points, AnalScratch& scratch)
 {
-    std::vector<AddressBlock> result;
-    std::set<std::uint32_t> scanned;
+    std::vector<AddressBlock>& result = scratch.new_blocks;
+    std::vector<bool>& scanned = scratch.scanned;
+
+    result.clear();
+    scanned.assign(anal.main_block.data.size(), false);
 
     std::size_t i = 0;
 
@@ -225,16 +274,16 @@ static std::vector<AddressBlock> scan_code_at_points(AnalConfig const& anal, std
 
         while (i < scan_points.size() && range.contains(scan_points[i]))
         {
-            if (!scanned.count(scan_points[i]))
+            if (!scanned[scan_points[i] - anal.main_block.address])
             {
-                std::cerr << "Begin scan at point " << hex_string<4>(scan_points[i]) << std::endl;
+                anal.log << "Begin scan at point " << hex_string<4>(scan_points[i]) << std::endl;
 
                 std::uint32_t addr = scan_points[i];
                 std::uint32_t max_len = range.size - (addr - range.start);
 
                 while (addr < range.start + range.size)
                 {
-                    scanned.insert(addr);
+                    scanned[addr - anal.main_block.address] = true;
 
                     std::optional<AddressBlock> opt_block = scan_code(anal, { addr, max_len });
 
@@ -264,19 +313,19 @@ static std::vector<AddressBlock> scan_code_at_points(AnalConfig const& anal, std
             i++;
         }
     }
-
-    return result;
 }
 
-static std::vector<AddressBlock> find_code_blocks_using_symbols(AnalConfig const& anal, AddressBlock const& range)
+// Scans code from `points` (sorted), then from what the code found jumps to, and so on
+static void find_code_blocks_from_points(AnalConfig const& anal, AddressBlock const& range, std::vector<std::uint32_t> current_points,
+    std::vector<AddressBlock>& result, AnalScratch& scratch)
 {
-    std::vector<AddressBlock> result;
-
-    std::set<std::uint32_t> analysed_points;
+    std::vector<bool>& analysed_points = scratch.analysed;
 
-    auto const get_new_points = [&] (std::vector<AddressBlock> const& analysed_blocks) -> std::vector<std::uint32_t>
+    auto const get_new_points = [&] (std::vector<AddressBlock> const& analysed_blocks)
     {
-        std::vector<std::uint32_t> xrefs = list_code_xrefs(anal, analysed_blocks);
+        std::vector<std::uint32_t>& xrefs = scratch.points;
+
+        list_code_xrefs(anal, analysed_blocks, xrefs);
 
         xrefs.erase(std::remove_if(xrefs.begin(), xrefs.end(), [&] (std::uint32_t xref)
         {
@@ -287,20 +336,38 @@ static std::vector<AddressBlock> find_code_blocks_using_symbols(AnalConfig const
                 if (block.contains(xref))
                     return true;
 
-            if (analysed_points.count(xref))
+            if (analysed_points[xref - anal.main_block.address])
                 return true;
 
-            analysed_points.insert(xref);
+            analysed_points[xref - anal.main_block.address] = true;
 
             return false;
         }), xrefs.end());
 
         std::sort(xrefs.begin(), xrefs.end());
-
-        return xrefs;
+        std::swap(current_points, xrefs);
     };
 
-    std::vector<std::uint32_t> current_points;
+    do
+    {
+        inverted_blocks(range, result, scratch.ranges);
+        scan_code_at_points(anal, scratch.ranges, current_points, scratch);
+
+        std::vector<AddressBlock>& merged = scratch.merged_blocks;
+
+        merged.clear();
+        std::merge(result.begin(), result.end(), scratch.new_blocks.begin(), scratch.new_blocks.end(), std::back_inserter(merged));
+        std::swap(result, merged);
+
+        get_new_points(result);
+    }
+    while (!current_points.empty());
+}
+
+static std::vector<AddressBlock> find_code_blocks_using_symbols(AnalConfig const& anal, AddressBlock const& range, AnalScratch& scratch)
+{
+    std::vector<AddressBlock> result;
+    std::vector<std::uint32_t> points;
 
     for (Symbol const& symbol : anal.symbols)
     {
@@ -310,31 +377,186 @@ static std::vector<AddressBlock> find_code_blocks_using_symbols(AnalConfig const
         if (!(symbol.flags & Symbol::FLAG_EXEC))
             continue;
 
-        current_points.push_back(symbol.value);
+        points.push_back(symbol.value);
     }
 
-    std::sort(current_points.begin(), current_points.end());
-
-    do
+    for (std::uint32_t point : anal.code_points)
     {
-        std::vector<AddressBlock> new_blocks = scan_code_at_points(anal, inverted_blocks(range, result), current_points);
-        result = merge_sorted_vectors(result, new_blocks);
+        if (range.contains(point))
+            points.push_back(point);
     }
-    while (!(current_points = get_new_points(result)).empty());
+
+    std::sort(points.begin(), points.end());
+    points.erase(std::unique(points.begin(), points.end()), points.end());
+
+    find_code_blocks_from_points(anal, range, std::move(points), result, scratch);
 
     return result;
 }
 
-static std::vector<AddressBlock> find_code_blocks_linearly(AnalConfig const& anal, AddressBlock const& range)
+// Continues discovery from the targets of the pointer tables in what is left of `range`
+static void find_code_blocks_using_tables(AnalConfig const& anal, AddressBlock const& range, std::vector<AddressBlock>& result, AnalScratch& scratch)
 {
-    std::vector<AddressBlock> result;
+    list_data_reads(anal, result, scratch.points);
+
+    std::vector<CodePointCandidate> const candidates = find_pointer_table_targets(anal,
+        subtract_blocks(inverted_blocks(range, result), anal.fill_blocks), scratch.points);
 
-    std::cerr << "Begin linear scan at " << hex_string<4>(range.start) << std::endl;
+    std::vector<std::uint32_t> points;
+
+    for (CodePointCandidate const& candidate : candidates)
+    {
+        if (candidate.confidence >= anal.min_table_confidence && range.contains(candidate.address) && !address_blocks_contain(result, candidate.address))
+            points.push_back(candidate.address);
+    }
+
+    anal.log << "Seeding " << points.size() << " of " << candidates.size() << " pointer table targets (confidence at least "
+        << unsigned(anal.min_table_confidence) << "%)" << std::endl;
+
+    if (!points.empty())
+        find_code_blocks_from_points(anal, range, std::move(points), result, scratch);
+}
+
+// Continues discovery from the indirect targets constant propagation resolves in `result`, until it resolves no more
+static void find_code_blocks_using_constants(AnalConfig const& anal, AddressBlock const& range, std::vector<AddressBlock>& result, AnalScratch& scratch)
+{
+    while (true)
+    {
+        std::vector<std::uint32_t> points = resolve_indirect_targets(anal, build_flow_graph(anal, result));
+
+        points.erase(std::remove_if(points.begin(), points.end(), [&] (std::uint32_t point)
+        {
+            return !range.contains(point) || address_blocks_contain(result, point) || scratch.analysed[point - anal.main_block.address];
+        }), points.end());
+
+        if (points.empty())
+            return;
+
+        anal.log << "Seeding " << points.size() << " indirect jump target(s) resolved by constant propagation" << std::endl;
+
+        for (std::uint32_t point : points)
+            scratch.analysed[point - anal.main_block.address] = true;
+
+        std::vector<std::uint32_t>& known = scratch.merged_points;
+
+        known.clear();
+        std::merge(scratch.known_points.begin(), scratch.known_points.end(), points.begin(), points.end(), std::back_inserter(known));
+        std::swap(scratch.known_points, known);
+
+        find_code_blocks_from_points(anal, range, std::move(points), result, scratch);
+    }
+}
+
+// The linear scan prefilter rates windows of this many bytes
+constexpr std::uint32_t LIKELIHOOD_WINDOW = 32;
+
+// How much each window of `range` looks like code (percent), from decoding it once from start to end. Bytes of valid
+// instructions count for it; unknown opcodes, BRKs that aren't allowed and implausible operands are skipped over. Tiles,
+// text and padding decode to a few instructions over and over, so windows made mostly of one opcode or one addressing
+// mode are rated down.
+static void rate_code_likelihood(AnalConfig const& anal, AddressBlock const& range, std::vector<std::uint8_t>& result)
+{
+    result.clear();
+    result.reserve(range.size / LIKELIHOOD_WINDOW + 1);
+
+    SpanScanner bytes = anal.main_block.bytes(range);
+
+    std::array<std::uint8_t, 0x100> opcode_counts {};
+    std::array<std::uint8_t, 0x10> mode_counts {};
+
+    std::uint32_t valid_bytes = 0;
+    std::uint32_t instr_count = 0;
+
+    auto const end_window = [&] ()
+    {
+        std::uint32_t likelihood = std::min<std::uint32_t>(100, valid_bytes * 100 / LIKELIHOOD_WINDOW);
+
+        if (instr_count >= 8)
+        {
+            if (*std::max_element(opcode_counts.begin(), opcode_counts.end()) * 2 > instr_count)
+                likelihood /= 2;
+
+            if (*std::max_element(mode_counts.begin(), mode_counts.end()) * 4 > instr_count * 3)
+                likelihood /= 2;
+        }
+
+        result.push_back(likelihood);
+
+        opcode_counts.fill(0);
+        mode_counts.fill(0);
+        valid_bytes = 0;
+        instr_count = 0;
+    };
+
+    while (bytes.tell() < bytes.last())
+    {
+        std::size_t const offset = bytes.tell();
+
+        while (offset / LIKELIHOOD_WINDOW > result.size())
+            end_window();
+
+        std::uint8_t const opcode = bytes.consume();
+        OpInfo const* info = anal.get_opcode_info(opcode);
+
+        if (info == nullptr || (info->mnemonic == Mnem::BRK && !anal.allow_brk))
+            continue;
+
+        std::size_t const operand_size = get_addressing_mode_operand_size(info->addressing_mode);
+
+        if (bytes.tell() + operand_size > bytes.last())
+            continue;
+
+        Instr const instr = decode_instr_operand(range.start + offset, opcode, bytes);
+
+        if (find_bad_operand_target(anal, *info, instr.operand) != nullptr)
+        {
+            bytes.seek(offset + 1);
+            continue;
+        }
+
+        valid_bytes += 1 + operand_size;
+        instr_count++;
+
+        opcode_counts[opcode]++;
+        mode_counts[static_cast<std::size_t>(info->addressing_mode)]++;
+    }
+
+    while (result.size() * LIKELIHOOD_WINDOW < range.size)
+        end_window();
+}
+
+// Code starting near the end of a window mostly lies in the next one: a window is only skipped if that one is too
+static bool is_likely_code(AnalConfig const& anal, std::vector<std::uint8_t> const& likelihoods, std::size_t window)
+{
+    if (likelihoods[window] >= anal.min_code_likelihood)
+        return true;
+
+    return window + 1 < likelihoods.size() && likelihoods[window + 1] >= anal.min_code_likelihood;
+}
+
+static void find_code_blocks_linearly(AnalConfig const& anal, AddressBlock const& range, std::vector<AddressBlock>& result, AnalScratch& scratch)
+{
+    anal.log << "Begin linear scan at " << hex_string<4>(range.start) << std::endl;
+
+    if (anal.min_code_likelihood != 0)
+        rate_code_likelihood(anal, range, scratch.likelihoods);
+
+    scratch.linear_bytes += range.size;
 
     std::uint32_t current_offset = 0;
 
     while (current_offset < range.size)
     {
+        if (anal.min_code_likelihood != 0 && !is_likely_code(anal, scratch.likelihoods, current_offset / LIKELIHOOD_WINDOW))
+        {
+            std::uint32_t const next_offset = std::min(range.size, (current_offset / LIKELIHOOD_WINDOW + 1) * LIKELIHOOD_WINDOW);
+
+            scratch.skipped_bytes += next_offset - current_offset;
+            current_offset = next_offset;
+
+            continue;
+        }
+
         std::uint32_t const start = range.start + current_offset;
         std::uint32_t const size = range.size - current_offset;
 
@@ -352,36 +574,49 @@ static std::vector<AddressBlock> find_code_blocks_linearly(AnalConfig const& ana
             current_offset = current_offset + 1;
         }
     }
+}
+
+std::vector<AddressBlock> find_code_blocks_linearly(AnalConfig const& anal, AddressBlock const& range)
+{
+    AnalScratch scratch;
+
+    std::vector<AddressBlock> result;
+    find_code_blocks_linearly(anal, range, result, scratch);
 
     return result;
 }
 
-static std::vector<AddressBlock> find_code_blocks_linearly(AnalConfig const& anal, std::vector<AddressBlock> const& ranges)
+static void find_code_blocks_linearly(AnalConfig const& anal, std::vector<AddressBlock> const& ranges, std::vector<AddressBlock>& result, AnalScratch& scratch)
 {
-    std::vector<AddressBlock> result;
+    result.clear();
 
     for (AddressBlock const& range : ranges)
-    {
-        std::vector<AddressBlock> const new_blocks = find_code_blocks_linearly(anal, range);
+        find_code_blocks_linearly(anal, range, result, scratch);
 
-        result.reserve(result.size() + new_blocks.size());
-        std::copy(new_blocks.begin(), new_blocks.end(), std::back_inserter(result));
+    if (anal.min_code_likelihood != 0)
+    {
+        anal.log << "Linear scan skipped " << scratch.skipped_bytes << " of " << scratch.linear_bytes
+            << " bytes looking less than " << unsigned(anal.min_code_likelihood) << "% like code" << std::endl;
     }
-
-    return result;
 }
 
-static bool remove_bad_jump_blocks(AnalConfig const& anal, std::vector<AddressBlock>& blocks, std::vector<std::uint32_t> const& all_code_points)
+static bool remove_bad_jump_blocks(AnalConfig const& anal, std::vector<AddressBlock>& blocks, std::vector<std::uint32_t> const& all_code_points,
+    std::vector<std::uint32_t> const& known_points, std::vector<AddressBlock>& result)
 {
-    std::vector<AddressBlock> result;
+    result.clear();
     result.reserve(blocks.size());
-
-    std::cerr << "Checking for bad jump blocks..." << std::endl;
+    anal.log << "Checking for bad jump blocks..." << std::endl;
 
     SpanScanner bytes = SpanScanner::from_vector(anal.main_block.data);
 
     for (AddressBlock block : blocks)
     {
+        if (contains_known_code(known_points, block))
+        {
+            result.push_back(block);
+            continue;
+        }
+
         std::uint32_t start_offset = block.start - anal.main_block.address;
 
         bytes.seek(start_offset);
@@ -421,7 +656,7 @@ static bool remove_bad_jump_blocks(AnalConfig const& anal, std::vector<AddressBl
                     if (anal.main_block.contains(instr.operand) && !in_sorted_vector(all_code_points, (std::uint32_t) instr.operand))
                     {
                         // invalidate block up to now
-                        std::cerr << "Removed " << hex_string<4>(block.start) << ": " << hex_string<4>(instr.operand) << " is bad jump target." << std::endl;
+                        anal.log << "Removed " << hex_string<4>(block.start) << ": " << hex_string<4>(instr.operand) << " is bad jump target." << std::endl;
                         remove();
                     }
 
@@ -444,17 +679,18 @@ static bool remove_bad_jump_blocks(AnalConfig const& anal, std::vector<AddressBl
     return result.size() != blocks.size();
 }
 
-static bool remove_isolated_blocks(AnalConfig const& anal, std::vector<AddressBlock>& blocks)
+static bool remove_isolated_blocks(AnalConfig const& anal, std::vector<AddressBlock>& blocks, std::vector<std::uint32_t> const& known_points,
+    std::vector<AddressBlock>& result)
 {
-    std::vector<AddressBlock> result;
+    result.clear();
 
-    std::cerr << "Checking for isolated blocks..." << std::endl;
+    anal.log << "Checking for isolated blocks..." << std::endl;
 
     for (std::size_t i = 0; i < blocks.size(); ++i)
     {
         std::uint32_t const size = blocks[i].size;
 
-        if (size < 12) // TODO: this could be configurable
+        if (size < 12 && !contains_known_code(known_points, blocks[i])) // TODO: this could be configurable
         {
             std::uint32_t const prev_addr = (i == 0) ? anal.main_block.address : blocks[i-1].start + blocks[i-1].size;
             std::uint32_t const next_addr = (i == blocks.size()-1) ? anal.main_block.address + anal.main_block.data.size() : blocks[i+1].start;
@@ -464,7 +700,7 @@ static bool remove_isolated_blocks(AnalConfig const& anal, std::vector<AddressBl
 
             if ((lo_addr - size > prev_addr) && (hi_addr + size < next_addr))
             {
-                std::cerr << "Removed isolated block at " << hex_string<4>(lo_addr) << std::endl;
+                anal.log << "Removed isolated block at " << hex_string<4>(lo_addr) << std::endl;
                 continue;
             }
         }
@@ -478,18 +714,33 @@ static bool remove_isolated_blocks(AnalConfig const& anal, std::vector<AddressBl
 
 std::vector<AddressBlock> analyse_code_blocks(AnalConfig const& anal)
 {
-    std::vector<AddressBlock> result = find_code_blocks_using_symbols(anal, anal.main_block);
+    AnalScratch scratch;
+    scratch.analysed.assign(anal.main_block.data.size(), false);
+    scratch.known_points = anal.code_points;
+
+    std::vector<AddressBlock> result = find_code_blocks_using_symbols(anal, anal.main_block, scratch);
+
+    if (anal.propagate_constants)
+        find_code_blocks_using_constants(anal, anal.main_block, result, scratch);
+
+    if (anal.min_table_confidence != 0)
+        find_code_blocks_using_tables(anal, anal.main_block, result, scratch);
 
-    std::vector<AddressBlock> linear_blocks = find_code_blocks_linearly(anal, inverted_blocks(anal.main_block, result));
-    result = merge_sorted_vectors(result, linear_blocks);
+    // code the tables lead to may resolve more
+    if (anal.propagate_constants && anal.min_table_confidence != 0)
+        find_code_blocks_using_constants(anal, anal.main_block, result, scratch);
 
-    std::vector<std::uint32_t> code_points;
+    find_code_blocks_linearly(anal, subtract_blocks(subtract_blocks(inverted_blocks(anal.main_block, result), anal.data_blocks), anal.fill_blocks), scratch.new_blocks, scratch);
+    result = merge_sorted_vectors(result, scratch.new_blocks);
+
+    std::vector<std::uint32_t>& code_points = scratch.points;
 
     do
     {
-        code_points = list_code_points(anal, result);
+        list_code_points(anal, result, code_points);
     }
-    while (remove_bad_jump_blocks(anal, result, code_points) || remove_isolated_blocks(anal, result));
+    while (remove_bad_jump_blocks(anal, result, code_points, scratch.known_points, scratch.merged_blocks) ||
+        remove_isolated_blocks(anal, result, scratch.known_points, scratch.merged_blocks));
 
     return result;
 }
@@ -583,6 +834,15 @@ std::vector<Symbol> build_symbols(AnalConfig const& anal, std::vector<AddressBlo
         });
     }
 
+    if (anal.propagate_constants)
+    {
+        for (std::uint32_t target : resolve_indirect_targets(anal, build_flow_graph(anal, blocks)))
+        {
+            if (address_blocks_contain(blocks, target))
+                add_symbol(std::string("CODE_") + hex_string<4>(target), target, Symbol::FLAG_EXEC);
+        }
+    }
+
     std::sort(result.begin(), result.end(), Symbol::Compare {});
     result.erase(std::unique(result.begin(), result.end(), sym_compare), result.end());
 
@@ -5,6 +5,9 @@
 #include "6502.hh"
 #include "disasm.hh"
 #include "symbol.hh"
+#include "log.hh"
+
+#include <optional>
 
 struct Segment : public AddressBlock
 {
@@ -13,6 +16,9 @@ struct Segment : public AddressBlock
         FLAG_READ  = (1 << 0),
         FLAG_WRITE = (1 << 1),
         FLAG_EXEC  = (1 << 2),
+
+        // hardware registers: reads don't return what was written (emulation only)
+        FLAG_VOLATILE = (1 << 3),
     };
 
     std::string name;
@@ -26,8 +32,38 @@ struct AnalConfig : public OpInfoCache
     std::vector<Segment> segments;
     std::vector<Symbol> symbols;
 
+    // addresses known to be the start of an instruction (sorted), blocks containing them are never discarded
+    std::vector<std::uint32_t> code_points;
+
+    // known data (sorted, no overlaps), never scanned for code linearly
+    std::vector<AddressBlock> data_blocks;
+
+    // runs of a repeated byte (sorted), not scanned for code linearly either
+    std::vector<AddressBlock> fill_blocks;
+
+    Log log;
+
+    // the linear scan skips windows looking less like code than this (percent, 0: scans everything)
+    std::uint8_t min_code_likelihood;
+
+    // discovery continues from the targets of pointer tables rated at least this (percent, 0: doesn't look for tables)
+    std::uint8_t min_table_confidence;
+
     bool allow_brk : 1;
+
+    // discovery continues from the JMP (ind) and RTS targets constant propagation resolves
+    bool propagate_constants : 1;
 };
 
+constexpr std::uint8_t DEFAULT_MIN_CODE_LIKELIHOOD = 10;
+
 std::vector<AddressBlock> analyse_code_blocks(AnalConfig const& ctx);
+
+// steps of analyse_code_blocks
+std::optional<AddressBlock> scan_code(AnalConfig const& anal, AddressBlock const& range);
+std::vector<AddressBlock> find_code_blocks_linearly(AnalConfig const& anal, AddressBlock const& range);
+
+// replaces `result` with the operands of the absolute and relative jumps, branches and calls of `blocks` (unsorted)
+void list_code_xrefs(AnalConfig const& anal, std::vector<AddressBlock> const& blocks, std::vector<std::uint32_t>& result);
+
 std::vector<Symbol> build_symbols(AnalConfig const& anal, std::vector<AddressBlock> const& blocks, bool extended_symbols);
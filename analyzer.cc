@@ -0,0 +1,205 @@
+
+#include "analyzer.hh"
+
+#include "fill.hh"
+#include "flow.hh"
+
+#include <map>
+#include <sstream>
+
+Analyzer::Analyzer(std::vector<Segment> segments, std::vector<Symbol> symbols, AnalyzerOptions const& options,
+    std::vector<Signature> signatures)
+    : m_segments(std::move(segments)), m_symbols(std::move(symbols)), m_options(options), m_signatures(std::move(signatures))
+{
+    if (m_segments.empty())
+        m_segments.push_back({ { 0, 0x10000 }, "ALL", Segment::FLAG_READ | Segment::FLAG_WRITE | Segment::FLAG_EXEC });
+
+    std::sort(m_symbols.begin(), m_symbols.end(), Symbol::Compare {});
+}
+
+// Names the known routines found in the main block, and seeds the analysis with their instructions
+void Analyzer::add_signature_matches(AnalConfig& anal) const
+{
+    std::vector<SignatureMatch> const matches = m_signatures.find_matches(anal.main_block);
+
+    std::map<Signature const*, std::size_t> counts;
+
+    for (SignatureMatch const& match : matches)
+        counts[match.signature]++;
+
+    for (SignatureMatch const& match : matches)
+    {
+        Signature const& signature = *match.signature;
+
+        std::string name = signature.name;
+
+        if (counts[match.signature] > 1)
+            name += "_" + hex_string<4>(match.address);
+
+        anal.log << "Signature " << signature.name << " at " << hex_string<4>(match.address) << std::endl;
+        anal.symbols.push_back({ std::move(name), match.address, Symbol::FLAG_EXEC });
+
+        // up to the first byte that isn't an instruction, should the size be wrong
+        std::uint32_t const end = std::min<std::uint64_t>(std::uint64_t(match.address) + signature.size,
+            anal.main_block.address + anal.main_block.data.size());
+
+        for (std::uint32_t address = match.address; address < end;)
+        {
+            OpInfo const* const info = find_opcode_info(anal.main_block.data[address - anal.main_block.address]);
+
+            if (info == nullptr)
+                break;
+
+            std::uint32_t const next = address + 1 + get_addressing_mode_operand_size(info->addressing_mode);
+
+            if (next > end)
+                break;
+
+            anal.code_points.push_back(address);
+            address = next;
+        }
+    }
+}
+
+Analysis Analyzer::analyse(DataBlock main_block, CodeDataHints const& hints, Log const& log) const
+{
+    return analyse(std::move(main_block), m_symbols, hints, log);
+}
+
+Analysis Analyzer::analyse(DataBlock main_block, std::vector<Symbol> const& symbols, CodeDataHints const& hints, Log const& log) const
+{
+    Analysis result {};
+    AnalConfig& anal = result.anal;
+
+    anal.main_block = std::move(main_block);
+    anal.segments = m_segments;
+    anal.symbols = symbols;
+    anal.code_points = hints.code_points;
+    anal.data_blocks = hints.data_blocks;
+
+    if (m_options.min_fill_length != 0)
+        anal.fill_blocks = find_fill_runs(anal.main_block, m_options.min_fill_length);
+
+    anal.log = log;
+    anal.min_code_likelihood = m_options.min_code_likelihood;
+    anal.min_table_confidence = m_options.min_table_confidence;
+    anal.allow_brk = m_options.allow_brk;
+    anal.propagate_constants = m_options.propagate_constants;
+
+    std::vector<StackRoot> stack_roots;
+    std::vector<std::uint32_t> masked_entries;
+
+    if (anal.main_block.contains(0xFFFA) && anal.main_block.contains(0xFFFF))
+    {
+        char const* const vector_value_names[]
+        {
+            "ENTRY_NMI",
+            "ENTRY_RESET",
+            "ENTRY_IRQ",
+        };
+
+        for (std::size_t i = 0; i < 3; ++i)
+        {
+            std::uint8_t const lo = anal.main_block.data[0xFFFA - anal.main_block.address + 2*i + 0];
+            std::uint8_t const hi = anal.main_block.data[0xFFFA - anal.main_block.address + 2*i + 1];
+
+            std::uint32_t const val = lo | (hi << 8);
+
+            anal.symbols.push_back({ vector_value_names[i], val, Symbol::FLAG_EXEC });
+
+            // the CPU pushes the return address and status before entering NMI and IRQ handlers
+            stack_roots.push_back({ vector_value_names[i], val, (i == 1) ? 0u : 3u });
+
+            // so do they disable interrupts
+            if (i != 1)
+                masked_entries.push_back(val);
+        }
+    }
+
+    add_signature_matches(anal);
+
+    // NTSC NES frame length, other machines are in the same ballpark
+    EmuConfig const emu_config { m_options.emulate_frames, 29781, m_options.emulate_instructions };
+
+    if (m_options.emulate_frames != 0)
+    {
+        // profiled from the same run, which emulating again would only repeat
+        if (m_options.profile_count != 0)
+            result.profile.emplace();
+
+        EmuDiscovery discovery = discover_code_by_emulation(anal, emu_config, result.profile ? &*result.profile : nullptr);
+
+        for (std::uint32_t target : discovery.indirect_targets)
+            anal.symbols.push_back({ std::string("CODE_") + hex_string<4>(target), target, Symbol::FLAG_EXEC });
+
+        anal.code_points.insert(anal.code_points.end(), discovery.code_points.begin(), discovery.code_points.end());
+    }
+
+    std::sort(anal.symbols.begin(), anal.symbols.end(), Symbol::Compare {});
+
+    std::sort(anal.code_points.begin(), anal.code_points.end());
+    anal.code_points.erase(std::unique(anal.code_points.begin(), anal.code_points.end()), anal.code_points.end());
+
+    AnalysisCache::Result const cached = m_cache.get(anal, m_options.auto_symbols, [&] ()
+    {
+        std::vector<AddressBlock> blocks = analyse_code_blocks(anal);
+        std::vector<Symbol> new_symbols = build_symbols(anal, blocks, m_options.auto_symbols);
+
+        return CachedAnalysis { std::move(blocks), std::move(new_symbols) };
+    });
+
+    result.blocks = cached->blocks;
+    result.new_symbols = cached->new_symbols;
+    result.symbols = merge_sorted_vectors(anal.symbols, result.new_symbols);
+
+    result.xrefs = build_xref_index(anal, result.blocks);
+
+    if (m_options.stack_depth || m_options.irq_latency)
+    {
+        std::vector<std::uint32_t> entries = masked_entries;
+
+        for (StackRoot const& root : stack_roots)
+            entries.push_back(root.address);
+
+        FlowGraph const graph = build_flow_graph(anal, result.blocks, entries);
+
+        if (m_options.stack_depth)
+            result.stack_depths = analyse_stack_depth(anal, graph, stack_roots);
+
+        if (m_options.irq_latency)
+            result.masked_regions = analyse_masked_regions(anal, graph, masked_entries);
+    }
+
+    return result;
+}
+
+void Analyzer::print(Analysis const& analysis, std::ostream& output, std::vector<LineMark>* line_marks) const
+{
+    bool const line_comments = m_options.syntax != AsmSyntax::Julian;
+
+    std::ostringstream report_buffer;
+    std::ostream& reports = line_comments ? report_buffer : output;
+
+    if (m_options.stack_depth)
+        print_stack_depths(analysis.stack_depths, analysis.symbols, reports);
+
+    if (m_options.irq_latency)
+        print_masked_regions(analysis.masked_regions, analysis.symbols, reports);
+
+    if (analysis.profile)
+        print_profile_summary(*analysis.profile, analysis.symbols, m_options.profile_count, reports);
+
+    if (line_comments)
+        print_as_line_comments(report_buffer.str(), output);
+
+    print_symbols(analysis.anal.main_block, m_options.print_input_symbols ? analysis.symbols : analysis.new_symbols, output);
+
+    PrintExtras extras;
+    extras.profile = analysis.profile ? &*analysis.profile : nullptr;
+    extras.xrefs = m_options.xrefs ? &analysis.xrefs : nullptr;
+    extras.fills = &analysis.anal.fill_blocks;
+    extras.line_marks = line_marks;
+    extras.syntax = m_options.syntax;
+
+    print_listing(analysis.anal.main_block, analysis.blocks, analysis.symbols, output, extras);
+}
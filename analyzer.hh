@@ -0,0 +1,99 @@
+
+#pragma once
+
+#include "common.hh"
+#include "anal.hh"
+#include "print.hh"
+#include "stack.hh"
+#include "latency.hh"
+#include "emu.hh"
+#include "cdl.hh"
+#include "cache.hh"
+#include "xref.hh"
+#include "signatures.hh"
+
+#include <optional>
+#include <ostream>
+
+struct AnalyzerOptions
+{
+    // frames to emulate for code discovery (0: don't)
+    std::uint32_t emulate_frames;
+    std::uint64_t emulate_instructions;
+
+    // hottest routines to summarize when profiling (0: don't profile)
+    std::uint32_t profile_count;
+
+    // see AnalConfig
+    std::uint8_t min_code_likelihood;
+    std::uint8_t min_table_confidence;
+
+    // shortest run of a repeated byte to skip and list as a fill (0: don't)
+    std::uint32_t min_fill_length;
+
+    bool allow_brk : 1;
+    bool propagate_constants : 1;
+    bool auto_symbols : 1;
+    bool print_input_symbols : 1;
+    bool stack_depth : 1;
+    bool irq_latency : 1;
+
+    // print "referenced from" comments under labels
+    bool xrefs : 1;
+
+    AsmSyntax syntax;
+};
+
+// Everything known about one analysed block of input
+struct Analysis
+{
+    AnalConfig anal;
+
+    std::vector<AddressBlock> blocks;
+
+    // symbols generated by the analysis, and those merged with the input symbols (both sorted)
+    std::vector<Symbol> new_symbols;
+    std::vector<Symbol> symbols;
+
+    XrefIndex xrefs;
+
+    std::vector<StackDepth> stack_depths;
+    std::vector<MaskedRegion> masked_regions;
+    std::optional<EmuProfile> profile;
+};
+
+// Holds parsed segment, symbol and signature tables, to be reused across many analyses.
+// analyse may be called from many threads at once: results of identical inputs are shared.
+struct Analyzer
+{
+    Analyzer(std::vector<Segment> segments, std::vector<Symbol> symbols, AnalyzerOptions const& options,
+        std::vector<Signature> signatures = {});
+
+    std::vector<Segment> const& segments() const { return m_segments; }
+    std::vector<Symbol> const& symbols() const { return m_symbols; }
+    AnalyzerOptions const& options() const { return m_options; }
+    SignatureMatcher const& signatures() const { return m_signatures; }
+
+    AnalysisCache const& cache() const { return m_cache; }
+
+    // forgets shared results, say between unrelated inputs of a long-lived analyzer
+    void clear_cache() const { m_cache.clear(); }
+
+    Analysis analyse(DataBlock main_block, CodeDataHints const& hints = {}, Log const& log = {}) const;
+
+    // `symbols` (sorted) are used instead of the symbol table: say, those of the fixed bank on top of it
+    Analysis analyse(DataBlock main_block, std::vector<Symbol> const& symbols, CodeDataHints const& hints, Log const& log) const;
+
+    // `line_marks`, if given, is filled with where each address is listed in the output
+    void print(Analysis const& analysis, std::ostream& output, std::vector<LineMark>* line_marks = nullptr) const;
+
+private:
+    void add_signature_matches(AnalConfig& anal) const;
+
+    std::vector<Segment> m_segments;
+    std::vector<Symbol> m_symbols;
+    AnalyzerOptions m_options;
+    SignatureMatcher m_signatures;
+
+    mutable AnalysisCache m_cache;
+};
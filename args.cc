@@ -2,76 +2,122 @@
 #include "args.hh"
 
 #include "common.hh"
+#include "alloc.hh"
 
 #include <argp.h>
+#include <charconv>
 
 char const* /* const */ argp_program_version     = "julian " JULIAN_VERSION_STRING;
 char const* /* const */ argp_program_bug_address = "https://github.com/StanHash/julian/issues";
 
-static char const julian_argp_arg[] = "INPUT[:OFFSET:SIZE] ADDRESS";
-static char const julian_argp_doc[] = "Disassemble 6502 from pure data";
+static char const julian_argp_arg[] = "INPUT[:OFFSET:SIZE] ADDRESS\n-B <banks.csv> INPUT\n-b <manifest>\nquery INDEX WHERE...";
+static char const julian_argp_doc[] = "Disassemble 6502 from pure data"
+    "\vBatch manifest lines are \"INPUT[:OFFSET:SIZE] ADDRESS OUTPUT\", '#' starts a comment."
+    " Bank layout tables have columns name,offset,size,address,flags (f: fixed bank)."
+    " Signature tables have columns name,pattern,size (pattern: hex bytes separated by spaces, ?? for any; size: - for that of the pattern).";
+
+enum
+{
+    // long options only
+    KEY_ALLOC_STATS = 0x100,
+    KEY_FILL,
+    KEY_TABLES,
+    KEY_DIFF,
+};
 
 static argp_option julian_argp_options[] =
 {
     { "output",   'o', "<output>",       0, "output file [default: stdout]", 0 },
     { "segments", 'm', "<segments.csv>", 0, "input segment table", 0 },
     { "symbols",  's', "<symbols.csv>",  0, "input symbol table", 0 },
+    { "signatures", 'g', "<signatures.csv>", 0, "name the known routines of the signature table found in the input, and analyse them as code", 0 },
+    { "cdl",      'c', "<log.cdl>[:OFFSET]", 0, "code/data logger file (FCEUX or Mesen) to take hints from", 0 },
+    { "trace",    't', "<trace.log>",    0, "emulator trace log to take code hints from", 0 },
+    { "emulate",  'e', "<frames>",       0, "emulate from the reset vector for this many frames to discover code", 0 },
+    { "instructions", 'i', "<count>",    0, "stop emulating after about this many instructions", 0 },
+    { "profile",  'P', "<count>",        0, "profile execution while emulating, and summarize the <count> hottest routines", 0 },
+    { "batch",    'b', "<manifest>",     0, "disassemble every input listed in the manifest, sharing segment and symbol tables", 0 },
+    { "banks",    'B', "<banks.csv>",    0, "disassemble the banks of INPUT described in the bank layout table", 0 },
+    { "format",   'F', "<format>",       0, "output format: asm (listing), jsonl or binary (records) [default: asm]", 0 },
+    { "syntax",   'a', "<syntax>",       0, "listing syntax: julian, ca65, asm6, nesasm or acme [default: julian]", 0 },
+    { "index",    'I', "<index>",        0, "also write a binary index of the analysis, for julian query", 0 },
+    { "serve",    'S', "<socket>",       0, "keep the analysis in memory and answer requests on this Unix domain socket", 0 },
+    { "likelihood", 'l', "<percent>",    0, "skip looking for code linearly in 32 byte windows looking less than this like code (0: don't) [default: 10]", 0 },
+    { "fill",     KEY_FILL, "<length>",  0, "list runs of at least this many copies of a byte as fills, and don't look for code in them (0: don't) [default: 32]", 0 },
+    { "tables",   KEY_TABLES, "<percent>", 0, "look for code from the targets of pointer tables rated at least this (0: don't look for tables) [default: 75]", 0 },
+    { "diff",     KEY_DIFF, "<input>[:OFFSET:SIZE]", 0, "write the input symbol table moved to where its code went in this other version of INPUT (mapped at the same address)", 0 },
+    { "jobs",     'j', "<count>",        0, "worker threads in batch and bank mode [default: one per hardware thread]", 0 },
+    { "alloc-stats", KEY_ALLOC_STATS, "json", OPTION_ARG_OPTIONAL, "report allocations of each phase to stderr, as a table or JSON (builds with ALLOC_STATS=1)", 0 },
 
     { nullptr,    'f', "<flag>",         0, "set a flag. flags:", 2 },
     { "  brk",                 0, nullptr, OPTION_DOC, "allow BRK instructions to be analysed", 2 },
     { "  auto-symbols",        0, nullptr, OPTION_DOC, "generate symbols for all addresses", 2 },
     { "  print-input-symbols", 0, nullptr, OPTION_DOC, "print input symbols alongside analysed ones", 2 },
+    { "  stack-depth",         0, nullptr, OPTION_DOC, "report maximum stack depth from each vector entry", 2 },
+    { "  irq-latency",         0, nullptr, OPTION_DOC, "report longest regions running with interrupts disabled", 2 },
+    { "  xrefs",               0, nullptr, OPTION_DOC, "list references under each label", 2 },
+    { "  no-propagation",      0, nullptr, OPTION_DOC, "don't resolve JMP (ind) and RTS targets by constant propagation", 2 },
 
     {},
 };
 
-static void julian_argp_parse_positional(Args& args, int num, std::string_view const& arg, argp_state* st)
+InputRange parse_input_range(std::string_view const& arg)
 {
-    switch (num)
-    {
+    std::size_t const colon_pos = arg.find_first_of(':');
 
-    case 0:
-    {
-        // Input positional
+    InputRange result { std::string { arg.substr(0, colon_pos) }, 0, 0 };
 
-        std::size_t const colon_pos = arg.find_first_of(':');
+    if (colon_pos == std::string_view::npos)
+        return result;
 
-        args.input_filename = (colon_pos != std::string_view::npos)
-            ? arg.substr(0, colon_pos) : arg;
+    std::string_view input_range = arg.substr(colon_pos+1);
+    std::size_t const range_colon_pos = input_range.find_first_of(':');
 
-        args.input_offset = 0;
-        args.input_size = 0;
+    if (range_colon_pos == std::string_view::npos)
+        throw InputRangeError("Input range (\"" + std::string { input_range } + "\") requires 2 components (offset:size)");
 
-        if (colon_pos != std::string_view::npos)
-        {
-            std::string_view input_range = arg.substr(colon_pos+1);
-            std::size_t const range_colon_pos = input_range.find_first_of(':');
+    std::string_view offset_view = input_range.substr(0, range_colon_pos);
+    std::string_view size_view = input_range.substr(range_colon_pos + 1);
 
-            if (range_colon_pos == std::string_view::npos)
-            {
-                std::string const input_range_str { input_range };
-                argp_error(st, "Input range (\"%s\") requires 2 components (offset:size)", input_range_str.c_str());
-                return;
-            }
+    try { result.offset = hex_decode<std::size_t>(offset_view); }
+    catch (HexDecodeError const& e)
+    {
+        throw InputRangeError("Couldn't parse range offset (" + std::string { offset_view } + "): " + e.what());
+    }
 
-            std::string_view offset_view = input_range.substr(0, range_colon_pos);
-            std::string_view size_view = input_range.substr(range_colon_pos + 1);
+    try { result.size = hex_decode<std::size_t>(size_view); }
+    catch (HexDecodeError const& e)
+    {
+        throw InputRangeError("Couldn't parse range size (" + std::string { size_view } + "): " + e.what());
+    }
 
-            try { args.input_offset = hex_decode<std::size_t>(offset_view); }
-            catch (HexDecodeError const& e)
-            {
-                std::string const offset_str { offset_view };
-                argp_failure(st, 2, 0, "Couldn't parse range offset (%s): %s", offset_str.c_str(), e.what());
-                return;
-            }
+    return result;
+}
 
-            try { args.input_size = hex_decode<std::size_t>(size_view); }
-            catch (HexDecodeError const& e)
-            {
-                std::string const size_str { size_view };
-                argp_failure(st, 2, 0, "Couldn't parse range size (%s): %s", size_str.c_str(), e.what());
-                return;
-            }
+template<typename IntType>
+static void parse_decimal(IntType& result, std::string_view const& arg, argp_state* st)
+{
+    auto const [end, error] = std::from_chars(arg.data(), arg.data() + arg.size(), result);
+
+    if (error != std::errc() || end != arg.data() + arg.size())
+    {
+        std::string const arg_str { arg };
+        argp_error(st, "Bad number: %s", arg_str.c_str());
+    }
+}
+
+static void julian_argp_parse_positional(Args& args, int num, std::string_view const& arg, argp_state* st)
+{
+    switch (num)
+    {
+
+    case 0:
+    {
+        try { args.input = parse_input_range(arg); }
+        catch (InputRangeError const& e)
+        {
+            argp_failure(st, 2, 0, "%s", e.what());
+            return;
         }
 
         break;
@@ -121,6 +167,162 @@ static error_t julian_argp_parser(int key, char* arg, argp_state* st)
         args.opt_symbol_file = arg_view;
         break;
 
+    case 'g':
+        args.opt_signature_file = arg_view;
+        break;
+
+    case 'c':
+    {
+        std::size_t const colon_pos = arg_view.find_last_of(':');
+
+        args.opt_cdl_file = arg_view.substr(0, colon_pos);
+        args.cdl_offset = 0;
+
+        if (colon_pos != std::string_view::npos)
+        {
+            std::string_view const offset_view = arg_view.substr(colon_pos + 1);
+
+            try { args.cdl_offset = hex_decode<std::size_t>(offset_view); }
+            catch (HexDecodeError const& e)
+            {
+                std::string const offset_str { offset_view };
+                argp_failure(st, 2, 0, "Couldn't parse code/data log offset (%s): %s", offset_str.c_str(), e.what());
+            }
+        }
+
+        break;
+    }
+
+    case 't':
+        args.opt_trace_file = arg_view;
+        break;
+
+    case 'e':
+        parse_decimal(args.emulate_frames, arg_view, st);
+        break;
+
+    case 'i':
+        parse_decimal(args.emulate_instructions, arg_view, st);
+        break;
+
+    case 'P':
+        parse_decimal(args.profile_count, arg_view, st);
+        break;
+
+    case 'b':
+        args.opt_batch_file = arg_view;
+        break;
+
+    case 'B':
+        args.opt_bank_file = arg_view;
+        break;
+
+    case 'F':
+        if (arg_view == "asm")
+            args.record_format = std::nullopt;
+
+        else if (arg_view == "jsonl")
+            args.record_format = RecordFormat::Jsonl;
+
+        else if (arg_view == "binary")
+            args.record_format = RecordFormat::Binary;
+
+        else
+        {
+            std::string const arg_str { arg_view };
+            argp_error(st, "Unknown output format: %s", arg_str.c_str());
+        }
+
+        break;
+
+    case 'a':
+    {
+        std::optional<AsmSyntax> const syntax = parse_asm_syntax(arg_view);
+
+        if (!syntax)
+        {
+            std::string const arg_str { arg_view };
+            argp_error(st, "Unknown syntax: %s", arg_str.c_str());
+        }
+
+        args.syntax = *syntax;
+        break;
+    }
+
+    case 'I':
+        args.opt_index_file = arg_view;
+        break;
+
+    case 'S':
+        args.opt_socket_file = arg_view;
+        break;
+
+    case 'j':
+        parse_decimal(args.jobs, arg_view, st);
+        break;
+
+    case 'l':
+    {
+        std::uint8_t likelihood = 0;
+        parse_decimal(likelihood, arg_view, st);
+
+        if (likelihood > 100)
+            argp_error(st, "Likelihood is a percentage: %u", unsigned(likelihood));
+
+        args.min_code_likelihood = likelihood;
+        break;
+    }
+
+    case KEY_FILL:
+    {
+        std::uint32_t length = 0;
+        parse_decimal(length, arg_view, st);
+
+        if (length == 1)
+            argp_error(st, "A fill is at least 2 bytes long");
+
+        args.min_fill_length = length;
+        break;
+    }
+
+    case KEY_DIFF:
+    {
+        try { args.opt_diff_input = parse_input_range(arg_view); }
+        catch (InputRangeError const& e)
+        {
+            argp_failure(st, 2, 0, "%s", e.what());
+            return 0;
+        }
+
+        break;
+    }
+
+    case KEY_TABLES:
+    {
+        std::uint8_t confidence = 0;
+        parse_decimal(confidence, arg_view, st);
+
+        if (confidence > 100)
+            argp_error(st, "Confidence is a percentage: %u", unsigned(confidence));
+
+        args.min_table_confidence = confidence;
+        break;
+    }
+
+    case KEY_ALLOC_STATS:
+        if (!alloc_counting())
+            argp_error(st, "Allocation statistics need a build with them (make ALLOC_STATS=1)");
+
+        if (arg != nullptr && arg_view != "json")
+        {
+            std::string const arg_str { arg_view };
+            argp_error(st, "Unknown allocation statistics format: %s", arg_str.c_str());
+        }
+
+        args.alloc_stats = true;
+        args.alloc_stats_json = arg != nullptr;
+        break;
+
     case 'f':
         if (arg_view == "brk")
             args.flag_brk = true;
@@ -131,6 +333,18 @@ static error_t julian_argp_parser(int key, char* arg, argp_state* st)
         else if (arg_view == "print-input-symbols")
             args.flag_print_input_symbols = true;
 
+        else if (arg_view == "stack-depth")
+            args.flag_stack_depth = true;
+
+        else if (arg_view == "irq-latency")
+            args.flag_irq_latency = true;
+
+        else if (arg_view == "xrefs")
+            args.flag_xrefs = true;
+
+        else if (arg_view == "no-propagation")
+            args.flag_no_propagation = true;
+
         else
         {
             std::string const arg_str { arg_view };
@@ -144,9 +358,30 @@ static error_t julian_argp_parser(int key, char* arg, argp_state* st)
         break;
 
     case ARGP_KEY_END:
-        if (st->arg_num != 2)
+        if (st->arg_num != (args.opt_batch_file ? 0 : args.opt_bank_file ? 1 : 2))
             argp_usage(st);
 
+        if (args.opt_bank_file && args.opt_batch_file)
+            argp_error(st, "Bank and batch mode can't be used together");
+
+        if ((args.opt_socket_file || args.opt_index_file) && (args.opt_bank_file || args.opt_batch_file))
+            argp_error(st, "Server mode and indexes work on a single input");
+
+        if (args.record_format && (args.opt_bank_file || args.opt_index_file || args.opt_socket_file))
+            argp_error(st, "Record output can't be used in bank or server mode, nor with an index");
+
+        if (args.opt_bank_file && (args.opt_trace_file || args.emulate_frames != 0))
+            argp_error(st, "Trace logs and emulation need the whole address space and can't be used in bank mode");
+
+        if (args.opt_batch_file && (args.opt_output_file || args.opt_cdl_file || args.opt_trace_file))
+            argp_error(st, "Output, code/data log and trace options are per input and can't be used in batch mode");
+
+        if (args.opt_diff_input && (args.opt_bank_file || args.opt_batch_file || args.opt_socket_file || args.opt_index_file || args.record_format))
+            argp_error(st, "Diff mode works on a single input and only writes a symbol table");
+
+        if (args.profile_count != 0 && args.emulate_frames == 0)
+            argp_error(st, "Profiling requires emulation (-e)");
+
         break;
 
     }
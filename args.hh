@@ -3,23 +3,80 @@
 
 #include <cstdint>
 #include <optional>
+#include <string>
 #include <string_view>
+#include <stdexcept>
 
-struct Args
+#include "records.hh"
+#include "syntax.hh"
+
+struct InputRange
 {
-    std::string_view input_filename;
-    std::size_t input_offset;
-    std::size_t input_size;
+    std::string filename;
 
+    std::size_t offset;
+    std::size_t size; // 0: up to the end of the file
+};
+
+struct InputRangeError : public std::runtime_error
+{
+    using std::runtime_error::runtime_error;
+};
+
+// "INPUT[:OFFSET:SIZE]", throws InputRangeError
+InputRange parse_input_range(std::string_view const& arg);
+
+struct Args
+{
+    InputRange input;
     std::uint32_t base_address;
 
     std::optional<std::string_view> opt_output_file;
     std::optional<std::string_view> opt_segment_file;
     std::optional<std::string_view> opt_symbol_file;
+    std::optional<std::string_view> opt_signature_file;
+    std::optional<std::string_view> opt_cdl_file;
+    std::optional<std::string_view> opt_trace_file;
+    std::optional<std::string_view> opt_batch_file;
+    std::optional<std::string_view> opt_bank_file;
+    std::optional<std::string_view> opt_socket_file;
+    std::optional<std::string_view> opt_index_file;
+
+    // other version of the input to move the symbol table to
+    std::optional<InputRange> opt_diff_input;
+
+    // worker threads in batch and bank mode (0: one per hardware thread)
+    std::uint32_t jobs;
+
+    // DEFAULT_MIN_CODE_LIKELIHOOD, DEFAULT_MIN_FILL_LENGTH and DEFAULT_MIN_TABLE_CONFIDENCE if none
+    std::optional<std::uint8_t> min_code_likelihood;
+    std::optional<std::uint32_t> min_fill_length;
+    std::optional<std::uint8_t> min_table_confidence;
+
+    // assembler listing if none
+    std::optional<RecordFormat> record_format;
+    AsmSyntax syntax;
+
+    // where the input starts in the code/data log
+    std::size_t cdl_offset;
+
+    // frames to emulate for code discovery (0: don't)
+    std::uint32_t emulate_frames;
+    std::uint64_t emulate_instructions;
+
+    // hottest routines to summarize when profiling (0: don't profile)
+    std::uint32_t profile_count;
 
     bool flag_brk : 1;
     bool flag_auto_symbols : 1;
     bool flag_print_input_symbols : 1;
+    bool flag_stack_depth : 1;
+    bool flag_irq_latency : 1;
+    bool flag_xrefs : 1;
+    bool flag_no_propagation : 1;
+
+    bool alloc_stats : 1;
+    bool alloc_stats_json : 1;
 };
 
 Args parse_args(int argc, char** argv);
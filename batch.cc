@@ -0,0 +1,142 @@
+
+#include "batch.hh"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+std::vector<BatchJob> read_batch_manifest(std::istream& input)
+{
+    std::vector<BatchJob> result;
+
+    std::string line;
+    std::size_t line_number = 0;
+
+    while (std::getline(input, line))
+    {
+        line_number++;
+
+        std::size_t const comment_pos = line.find('#');
+
+        if (comment_pos != std::string::npos)
+            line.resize(comment_pos);
+
+        std::istringstream fields(line);
+
+        std::string input_field, address_field, output_field, extra_field;
+        fields >> input_field >> address_field >> output_field >> extra_field;
+
+        if (input_field.empty())
+            continue;
+
+        std::string const where = "line " + std::to_string(line_number) + ": ";
+
+        if (output_field.empty() || !extra_field.empty())
+            throw BatchError(where + "expected \"INPUT[:OFFSET:SIZE] ADDRESS OUTPUT\"");
+
+        BatchJob job {};
+
+        try { job.input = parse_input_range(input_field); }
+        catch (InputRangeError const& e)
+        {
+            throw BatchError(where + e.what());
+        }
+
+        try { job.base_address = hex_decode<std::uint32_t>(address_field); }
+        catch (HexDecodeError const& e)
+        {
+            throw BatchError(where + "Couldn't parse address (" + address_field + "): " + e.what());
+        }
+
+        job.output_file = std::move(output_field);
+
+        result.push_back(std::move(job));
+    }
+
+    return result;
+}
+
+unsigned parallel_for(std::size_t count, unsigned thread_count, std::function<void(std::size_t index)> const& func)
+{
+    if (thread_count == 0)
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+
+    thread_count = std::min<std::size_t>(thread_count, std::max<std::size_t>(count, 1));
+
+    std::atomic<std::size_t> next { 0 };
+
+    auto const worker = [&] ()
+    {
+        for (std::size_t i = next++; i < count; i = next++)
+            func(i);
+    };
+
+    std::vector<std::thread> threads;
+
+    for (unsigned i = 1; i < thread_count; ++i)
+        threads.emplace_back(worker);
+
+    worker();
+
+    for (std::thread& thread : threads)
+        thread.join();
+
+    return thread_count;
+}
+
+std::size_t run_batch(std::vector<BatchJob> const& jobs, unsigned thread_count, BatchFunc const& func, std::ostream& status)
+{
+    using Clock = std::chrono::steady_clock;
+
+    std::atomic<std::size_t> failures { 0 };
+
+    std::mutex status_mutex;
+    std::size_t finished = 0;
+
+    Clock::time_point const batch_start = Clock::now();
+
+    thread_count = parallel_for(jobs.size(), thread_count, [&] (std::size_t i)
+    {
+        BatchJob const& job = jobs[i];
+
+        std::ostringstream errors;
+        Clock::time_point const job_start = Clock::now();
+
+        bool ok;
+
+        try
+        {
+            ok = func(job, errors);
+        }
+        catch (std::exception const& e)
+        {
+            errors << e.what() << std::endl;
+            ok = false;
+        }
+
+        auto const millis = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - job_start).count();
+
+        if (!ok)
+            failures++;
+
+        std::lock_guard<std::mutex> const lock(status_mutex);
+
+        finished++;
+
+        status << "[" << finished << "/" << jobs.size() << "] "
+            << (ok ? "ok     " : "FAILED ") << job.input.filename << " -> " << job.output_file
+            << " (" << millis << " ms)" << std::endl;
+
+        if (!ok)
+            status << errors.str();
+    });
+
+    auto const millis = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - batch_start).count();
+
+    status << jobs.size() << " jobs, " << (jobs.size() - failures) << " ok, " << failures << " failed, "
+        << millis << " ms on " << thread_count << " threads" << std::endl;
+
+    return failures;
+}
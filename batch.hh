@@ -0,0 +1,34 @@
+
+#pragma once
+
+#include "common.hh"
+#include "args.hh"
+
+#include <functional>
+#include <istream>
+#include <ostream>
+
+struct BatchJob
+{
+    InputRange input;
+    std::uint32_t base_address;
+    std::string output_file;
+};
+
+struct BatchError : public std::runtime_error
+{
+    using std::runtime_error::runtime_error;
+};
+
+// Calls func(i) for each i in [0, count) on up to `thread_count` threads (0: one per hardware thread),
+// the calling thread included. Returns the number of threads used.
+unsigned parallel_for(std::size_t count, unsigned thread_count, std::function<void(std::size_t index)> const& func);
+
+// One job per line: "INPUT[:OFFSET:SIZE] ADDRESS OUTPUT". Throws BatchError.
+std::vector<BatchJob> read_batch_manifest(std::istream& input);
+
+// Returns whether the job succeeded, complaining to `errors` if it didn't
+using BatchFunc = std::function<bool(BatchJob const& job, std::ostream& errors)>;
+
+// Runs all jobs on `thread_count` workers, reporting on each as it finishes. Returns the number of failed jobs.
+std::size_t run_batch(std::vector<BatchJob> const& jobs, unsigned thread_count, BatchFunc const& func, std::ostream& status);
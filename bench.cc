@@ -0,0 +1,298 @@
+
+#include "alloc.hh"
+#include "anal.hh"
+#include "pointers.hh"
+#include "print.hh"
+#include "tables.hh"
+
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+
+namespace
+{
+
+// each benchmark runs at least once, and until this much time has elapsed
+constexpr std::chrono::milliseconds MIN_TIME { 250 };
+
+constexpr std::uint32_t ROM_ADDRESS = 0xC000;
+constexpr std::size_t ROM_SIZE = 0x4000;
+
+// keeps results alive so that the work isn't optimized out
+std::size_t volatile g_sink;
+
+struct Rng
+{
+    std::uint32_t state;
+
+    std::uint32_t next()
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+
+        return state;
+    }
+
+    std::uint32_t below(std::uint32_t bound)
+    {
+        return next() % bound;
+    }
+};
+
+// discards everything
+struct NullBuffer : public std::streambuf
+{
+    int overflow(int chr) override
+    {
+        return chr;
+    }
+
+    std::streamsize xsputn(char const*, std::streamsize count) override
+    {
+        return count;
+    }
+};
+
+template<typename Func>
+void bench(char const* name, std::size_t bytes, Func&& func)
+{
+    using Clock = std::chrono::steady_clock;
+
+    AllocCounters const before = alloc_counters();
+
+    std::uint64_t iterations = 0;
+    Clock::time_point const start = Clock::now();
+    Clock::duration elapsed;
+
+    do
+    {
+        func();
+        iterations++;
+
+        elapsed = Clock::now() - start;
+    }
+    while (elapsed < MIN_TIME);
+
+    double const ns = std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+    AllocCounters const after = alloc_counters();
+
+    std::printf("%-40s %8llu %14.0f %10.2f %12.1f %14.0f\n", name,
+        static_cast<unsigned long long>(iterations), ns, ns / std::max<std::size_t>(bytes, 1),
+        static_cast<double>(after.allocations - before.allocations) / iterations,
+        static_cast<double>(after.bytes - before.bytes) / iterations);
+}
+
+void emit(std::vector<byte_type>& rom, std::initializer_list<byte_type> bytes)
+{
+    rom.insert(rom.end(), bytes);
+}
+
+// Subroutines of plain instructions calling earlier ones, up to `code_size` bytes. The rest is NOPs (code) or noise
+// (data). Vectors point at the first routines.
+std::vector<byte_type> make_rom(std::uint32_t seed, std::size_t code_size, bool noise, std::vector<std::uint32_t>& entries)
+{
+    Rng rng { seed };
+
+    std::vector<byte_type> rom;
+
+    while (rom.size() + 64 < code_size)
+    {
+        entries.push_back(ROM_ADDRESS + rom.size());
+
+        std::uint32_t const count = 4 + rng.below(24);
+
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+            byte_type const imm = rng.next();
+            byte_type const zp = rng.below(0x80);
+            std::uint16_t const ram = 0x200 + rng.below(0x600);
+
+            switch (rng.below(12))
+            {
+
+            case 0: emit(rom, { 0xA9, imm }); break;               // lda #imm
+            case 1: emit(rom, { 0xA5, zp }); break;                // lda zp
+            case 2: emit(rom, { 0x85, zp }); break;                // sta zp
+            case 3: emit(rom, { 0xAD, byte_type(ram), byte_type(ram >> 8) }); break; // lda abs
+            case 4: emit(rom, { 0x8D, byte_type(ram), byte_type(ram >> 8) }); break; // sta abs
+            case 5: emit(rom, { 0xBD, byte_type(ram), byte_type(ram >> 8) }); break; // lda abs,x
+            case 6: emit(rom, { 0x69, imm }); break;               // adc #imm
+            case 7: emit(rom, { 0xE8 }); break;                    // inx
+            case 8: emit(rom, { 0xAA }); break;                    // tax
+            case 9: emit(rom, { 0x8D, 0x00, 0x20 }); break;        // sta PPUCTRL
+            case 10: emit(rom, { 0xD0, 0x00 }); break;             // bne to the next instruction
+
+            default:
+            {
+                std::uint32_t const target = entries[rng.below(entries.size())];
+                emit(rom, { 0x20, byte_type(target), byte_type(target >> 8) }); // jsr
+                break;
+            }
+
+            }
+        }
+
+        emit(rom, { 0x60 }); // rts
+    }
+
+    while (rom.size() < ROM_SIZE - 6)
+        rom.push_back(noise ? rng.next() : 0xEA);
+
+    for (std::size_t i = 0; i < 3; ++i)
+        emit(rom, { byte_type(entries[i]), byte_type(entries[i] >> 8) });
+
+    return rom;
+}
+
+AnalConfig make_config(std::vector<byte_type> const& rom, std::vector<std::uint32_t> const& entries)
+{
+    AnalConfig anal;
+
+    anal.main_block = { ROM_ADDRESS, rom };
+
+    anal.segments.push_back({ { 0x0000, 0x0800 }, "RAM", Segment::FLAG_READ | Segment::FLAG_WRITE });
+    anal.segments.push_back({ { 0x2000, 0x0008 }, "PPU", Segment::FLAG_READ | Segment::FLAG_WRITE });
+    anal.segments.push_back({ { ROM_ADDRESS, ROM_SIZE }, "ROM", Segment::FLAG_READ | Segment::FLAG_EXEC });
+
+    anal.symbols.push_back({ "PPUCTRL", 0x2000, Symbol::FLAG_WRITE });
+
+    for (std::size_t i = 0; i < 3; ++i)
+        anal.symbols.push_back({ "ENTRY_" + std::to_string(i), entries[i], Symbol::FLAG_EXEC });
+
+    std::sort(anal.symbols.begin(), anal.symbols.end());
+
+    anal.min_code_likelihood = DEFAULT_MIN_CODE_LIKELIHOOD;
+    anal.min_table_confidence = DEFAULT_MIN_TABLE_CONFIDENCE;
+    anal.allow_brk = false;
+    anal.propagate_constants = true;
+
+    return anal;
+}
+
+std::string make_symbol_csv(std::size_t rows)
+{
+    std::string result = "name,value,flags\n";
+
+    for (std::size_t i = 0; i < rows; ++i)
+        result += "SYMBOL_" + std::to_string(i) + "," + hex_string<4>(i & 0xFFFF) + ",rw\n";
+
+    return result;
+}
+
+void bench_decode(char const* name, AnalConfig const& anal)
+{
+    DataBlock const& block = anal.main_block;
+
+    bench(name, block.data.size(), [&] ()
+    {
+        SpanScanner bytes = SpanScanner::from_vector(block.data);
+        std::size_t sum = 0;
+
+        while (bytes.tell() < bytes.last())
+            sum += decode_instruction(block.address + bytes.tell(), bytes).operand;
+
+        g_sink = sum;
+    });
+}
+
+void bench_scan(char const* name, AnalConfig const& anal)
+{
+    DataBlock const& block = anal.main_block;
+
+    // a scan from every byte, as the linear scan does in the worst case
+    bench(name, block.data.size(), [&] ()
+    {
+        std::size_t count = 0;
+
+        for (std::uint32_t offset = 0; offset < block.data.size(); ++offset)
+            count += scan_code(anal, { block.address + offset, std::uint32_t(block.data.size() - offset) }).has_value();
+
+        g_sink = count;
+    });
+}
+
+void bench_analysis(std::string const& kind, AnalConfig const& anal)
+{
+    std::size_t const size = anal.main_block.data.size();
+
+    bench(("find_code_blocks_linearly (" + kind + ")").c_str(), size, [&] ()
+    {
+        g_sink = find_code_blocks_linearly(anal, anal.main_block).size();
+    });
+
+    bench(("analyse_code_blocks (" + kind + ")").c_str(), size, [&] ()
+    {
+        g_sink = analyse_code_blocks(anal).size();
+    });
+
+    std::vector<AddressBlock> const blocks = analyse_code_blocks(anal);
+
+    bench(("build_symbols (" + kind + ")").c_str(), size, [&] ()
+    {
+        g_sink = build_symbols(anal, blocks, false).size();
+    });
+
+    std::vector<Symbol> const symbols = merge_sorted_vectors(anal.symbols, build_symbols(anal, blocks, false));
+
+    bench(("instr_to_string (" + kind + ")").c_str(), size, [&] ()
+    {
+        std::size_t length = 0;
+
+        for (AddressBlock const& block : blocks)
+        {
+            for_each_instr(anal.main_block.bytes(block), block, [&] (std::uint32_t, Instr const& instr)
+            {
+                length += instr_to_string(instr, symbols).size();
+            });
+        }
+
+        g_sink = length;
+    });
+
+    bench(("print_listing (" + kind + ")").c_str(), size, [&] ()
+    {
+        NullBuffer buffer;
+        std::ostream output(&buffer);
+
+        print_listing(anal.main_block, blocks, symbols, output);
+    });
+}
+
+}
+
+int main()
+{
+    std::vector<std::uint32_t> code_entries, data_entries;
+
+    std::vector<byte_type> const code_rom = make_rom(1, ROM_SIZE, false, code_entries);
+    std::vector<byte_type> const data_rom = make_rom(2, 0x400, true, data_entries);
+
+    AnalConfig const code_anal = make_config(code_rom, code_entries);
+    AnalConfig const data_anal = make_config(data_rom, data_entries);
+
+    std::printf("%-40s %8s %14s %10s %12s %14s\n", "benchmark", "iters", "ns/op", "ns/byte", "allocs/op", "alloc bytes/op");
+
+    bench_decode("decode_instruction (code)", code_anal);
+    bench_decode("decode_instruction (data)", data_anal);
+
+    bench_scan("scan_code (code)", code_anal);
+    bench_scan("scan_code (data)", data_anal);
+
+    bench_analysis("code", code_anal);
+    bench_analysis("data", data_anal);
+
+    for (std::size_t rows : { 10000, 100000, 1000000 })
+    {
+        std::string const csv = make_symbol_csv(rows);
+        std::string const name = "read_symbol_table (" + std::to_string(rows) + " rows)";
+
+        bench(name.c_str(), csv.size(), [&] ()
+        {
+            std::istringstream input(csv);
+            g_sink = read_symbol_table(input).size();
+        });
+    }
+
+    return 0;
+}
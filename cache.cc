@@ -0,0 +1,208 @@
+
+#include "cache.hh"
+
+namespace
+{
+
+// Everything the analysis depends on, laid out byte after byte
+struct KeyWriter
+{
+    std::vector<byte_type> bytes;
+
+    void add(void const* data, std::size_t size)
+    {
+        byte_type const* const begin = static_cast<byte_type const*>(data);
+        bytes.insert(bytes.end(), begin, begin + size);
+    }
+
+    template<typename IntType>
+    void add(IntType value)
+    {
+        static_assert(std::is_integral_v<IntType>);
+
+        std::uint64_t const wide = value;
+        add(&wide, sizeof(wide));
+    }
+};
+
+// FNV-1a, 64 bit
+std::uint64_t hash_key(std::vector<byte_type> const& key)
+{
+    std::uint64_t value = 0xCBF29CE484222325;
+
+    for (byte_type byte : key)
+        value = (value ^ byte) * 0x100000001B3;
+
+    return value;
+}
+
+}
+
+// Symbol names don't matter: the analysis only looks at addresses and flags
+static std::vector<byte_type> build_key(AnalConfig const& anal, bool extended_symbols)
+{
+    KeyWriter writer;
+
+    writer.add(anal.main_block.address);
+    writer.add(anal.main_block.data.size());
+    writer.add(anal.main_block.data.data(), anal.main_block.data.size());
+
+    writer.add(anal.segments.size());
+
+    for (Segment const& segment : anal.segments)
+    {
+        writer.add(segment.start);
+        writer.add(segment.size);
+        writer.add(segment.flags);
+    }
+
+    writer.add(anal.symbols.size());
+
+    for (Symbol const& symbol : anal.symbols)
+    {
+        writer.add(symbol.value);
+        writer.add(symbol.flags);
+    }
+
+    writer.add(anal.code_points.size());
+
+    for (std::uint32_t code_point : anal.code_points)
+        writer.add(code_point);
+
+    writer.add(anal.data_blocks.size());
+
+    for (AddressBlock const& block : anal.data_blocks)
+    {
+        writer.add(block.start);
+        writer.add(block.size);
+    }
+
+    writer.add(anal.fill_blocks.size());
+
+    for (AddressBlock const& block : anal.fill_blocks)
+    {
+        writer.add(block.start);
+        writer.add(block.size);
+    }
+
+    writer.add(anal.min_code_likelihood);
+    writer.add(anal.min_table_confidence);
+    writer.add(anal.allow_brk);
+    writer.add(anal.propagate_constants);
+    writer.add(extended_symbols);
+
+    return std::move(writer.bytes);
+}
+
+AnalysisCache::Result AnalysisCache::get(AnalConfig const& anal, bool extended_symbols, std::function<CachedAnalysis()> const& compute)
+{
+    std::vector<byte_type> key = build_key(anal, extended_symbols);
+    std::uint64_t const hash = hash_key(key);
+
+    std::promise<Result> promise;
+    std::shared_future<Result> result;
+
+    // of the entry made for this call, if any
+    std::uint64_t serial = 0;
+
+    {
+        std::lock_guard<std::mutex> const lock(m_mutex);
+
+        auto const it = m_index.find(hash);
+
+        if (it != m_index.end() && it->second->key == key)
+        {
+            m_hits++;
+            result = it->second->result;
+
+            m_entries.splice(m_entries.begin(), m_entries, it->second);
+        }
+        else
+        {
+            m_misses++;
+
+            // a hash collision: the newer input takes the place
+            if (it != m_index.end())
+            {
+                m_entries.erase(it->second);
+                m_index.erase(it);
+            }
+
+            if (m_capacity != 0)
+            {
+                if (m_entries.size() == m_capacity)
+                {
+                    m_index.erase(m_entries.back().hash);
+                    m_entries.pop_back();
+                }
+
+                serial = ++m_last_serial;
+
+                m_entries.push_front({ hash, std::move(key), serial, promise.get_future().share() });
+                m_index.emplace(hash, m_entries.begin());
+            }
+        }
+    }
+
+    if (result.valid())
+        return result.get();
+
+    // first one here: compute it, outside of the lock
+
+    Result computed;
+
+    try
+    {
+        computed = std::make_shared<CachedAnalysis const>(compute());
+    }
+    catch (...)
+    {
+        // those already waiting get the exception, later calls try again
+        {
+            std::lock_guard<std::mutex> const lock(m_mutex);
+
+            auto const it = m_index.find(hash);
+
+            if (it != m_index.end() && it->second->serial == serial)
+            {
+                m_entries.erase(it->second);
+                m_index.erase(it);
+            }
+        }
+
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+
+    promise.set_value(computed);
+    return computed;
+}
+
+void AnalysisCache::clear()
+{
+    std::lock_guard<std::mutex> const lock(m_mutex);
+
+    m_entries.clear();
+    m_index.clear();
+}
+
+std::size_t AnalysisCache::size() const
+{
+    std::lock_guard<std::mutex> const lock(m_mutex);
+
+    return m_entries.size();
+}
+
+std::size_t AnalysisCache::hits() const
+{
+    std::lock_guard<std::mutex> const lock(m_mutex);
+
+    return m_hits;
+}
+
+std::size_t AnalysisCache::misses() const
+{
+    std::lock_guard<std::mutex> const lock(m_mutex);
+
+    return m_misses;
+}
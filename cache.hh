@@ -0,0 +1,68 @@
+
+#pragma once
+
+#include "common.hh"
+#include "anal.hh"
+
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+// What analyse_code_blocks and build_symbols found for some input
+struct CachedAnalysis
+{
+    std::vector<AddressBlock> blocks;
+    std::vector<Symbol> new_symbols;
+};
+
+// Shares analysis results between inputs that are identical once mapped: mirrored banks, ROM revisions that only
+// differ elsewhere... Keyed by everything the analysis depends on, found by its hash and compared in full, so that a
+// collision is a miss. Keeps the `capacity` results last asked for, and forgets those whose computation threw. Safe to use from many threads: when two threads want the same
+// result, one computes it while the other waits.
+struct AnalysisCache
+{
+    using Result = std::shared_ptr<CachedAnalysis const>;
+
+    // enough for the banks of most multi-megabyte images, mirrors being near each other anyway
+    static constexpr std::size_t DEFAULT_CAPACITY = 256;
+
+    explicit AnalysisCache(std::size_t capacity = DEFAULT_CAPACITY)
+        : m_capacity(capacity) {}
+
+    Result get(AnalConfig const& anal, bool extended_symbols, std::function<CachedAnalysis()> const& compute);
+
+    // drops all results, those being computed are still handed to who's waiting for them
+    void clear();
+
+    std::size_t size() const;
+    std::size_t hits() const;
+    std::size_t misses() const;
+
+private:
+    struct Entry
+    {
+        std::uint64_t hash;
+        std::vector<byte_type> key;
+
+        // tells apart entries made for the same key at different times
+        std::uint64_t serial;
+
+        std::shared_future<Result> result;
+    };
+
+    std::size_t m_capacity;
+
+    mutable std::mutex m_mutex;
+
+    // most recently used first
+    std::list<Entry> m_entries;
+    std::unordered_map<std::uint64_t, std::list<Entry>::iterator> m_index;
+
+    std::uint64_t m_last_serial = 0;
+
+    std::size_t m_hits = 0;
+    std::size_t m_misses = 0;
+};
@@ -0,0 +1,231 @@
+
+#include "cdl.hh"
+
+#include <cctype>
+#include <cstring>
+#include <limits>
+#include <optional>
+
+namespace
+{
+
+// logs can be huge: they are only ever looked at one chunk at a time
+constexpr std::size_t CHUNK_SIZE = 0x10000;
+
+enum : byte_type
+{
+    CDL_CODE = (1 << 0),
+    CDL_DATA = (1 << 1),
+
+    // FCEUX: destination of an indirect jump
+    CDL_FCEUX_INDIRECT_CODE = (1 << 4),
+
+    // Mesen
+    CDL_MESEN_JUMP_TARGET = (1 << 2),
+    CDL_MESEN_SUB_ENTRY = (1 << 3),
+};
+
+constexpr char MESEN_MAGIC[] = "CDLv2";
+
+// magic followed by a CRC32
+constexpr std::size_t MESEN_HEADER_SIZE = 5 + 4;
+
+}
+
+CodeDataHints read_cdl(std::istream& input, DataBlock const& main_block, std::size_t offset)
+{
+    CodeDataHints result;
+
+    std::vector<char> chunk(CHUNK_SIZE);
+
+    // Step 1. figure out the flavour
+
+    input.read(chunk.data(), MESEN_HEADER_SIZE);
+
+    bool const mesen = input.gcount() == MESEN_HEADER_SIZE && std::memcmp(chunk.data(), MESEN_MAGIC, 5) == 0;
+
+    byte_type const entry_flags = mesen
+        ? (CDL_MESEN_JUMP_TARGET | CDL_MESEN_SUB_ENTRY)
+        : CDL_FCEUX_INDIRECT_CODE;
+
+    input.clear();
+    input.seekg(mesen ? MESEN_HEADER_SIZE : 0, std::ios::beg);
+
+    if (!input.ignore(offset))
+        return result;
+
+    // Step 2. scan the part that covers the input
+
+    byte_type prev = 0;
+    std::size_t index = 0;
+
+    auto const close_data = [&] (std::uint32_t address)
+    {
+        if (!result.data_blocks.empty() && result.data_blocks.back().size == 0)
+            result.data_blocks.back().size = address - result.data_blocks.back().start;
+    };
+
+    while (index < main_block.data.size() && input)
+    {
+        std::size_t const wanted = std::min(CHUNK_SIZE, main_block.data.size() - index);
+
+        input.read(chunk.data(), wanted);
+        std::size_t const count = input.gcount();
+
+        for (std::size_t i = 0; i < count; ++i, ++index)
+        {
+            byte_type const flags = chunk[i];
+            std::uint32_t const address = main_block.address + index;
+
+            bool const code = flags & CDL_CODE;
+            bool const data = (flags & CDL_DATA) && !code;
+
+            bool const prev_code = prev & CDL_CODE;
+            bool const prev_data = (prev & CDL_DATA) && !prev_code;
+
+            // code runs start with an instruction: the logger flags operand bytes too
+
+            if ((code && !prev_code) || (flags & entry_flags))
+                result.code_points.push_back(address);
+
+            if (data && !prev_data)
+                result.data_blocks.push_back({ address, 0 });
+
+            if (!data && prev_data)
+                close_data(address);
+
+            prev = flags;
+        }
+    }
+
+    close_data(main_block.address + index);
+
+    std::sort(result.code_points.begin(), result.code_points.end());
+    result.code_points.erase(std::unique(result.code_points.begin(), result.code_points.end()), result.code_points.end());
+
+    return result;
+}
+
+// Finds the address in lines such as "C123  A9 00  LDA #$00", "$C123:A9 00  LDA #$00" or "07:C123 ..."
+static std::optional<std::uint32_t> parse_trace_address(char const* line, std::size_t length)
+{
+    std::size_t i = 0;
+
+    auto const read_hex = [&] (std::uint32_t& value) -> std::size_t
+    {
+        std::size_t const start = i;
+
+        value = 0;
+
+        while (i < length && std::isxdigit(static_cast<unsigned char>(line[i])) && i - start < 8)
+        {
+            char const chr = line[i++];
+            value = (value << 4) | ((chr <= '9') ? chr - '0' : (chr | 0x20) - 'a' + 10);
+        }
+
+        return i - start;
+    };
+
+    while (i < length && (line[i] == ' ' || line[i] == '\t'))
+        i++;
+
+    if (i < length && line[i] == '$')
+        i++;
+
+    std::uint32_t value;
+    std::size_t digits = read_hex(value);
+
+    if (digits <= 2 && i < length && line[i] == ':')
+    {
+        // bank prefix
+
+        i++;
+
+        if (i < length && line[i] == '$')
+            i++;
+
+        digits = read_hex(value);
+    }
+
+    if (digits != 4)
+        return std::nullopt;
+
+    return value;
+}
+
+CodeDataHints read_trace_log(std::istream& input, DataBlock const& main_block)
+{
+    CodeDataHints result;
+
+    std::vector<std::uint8_t> arrivals(main_block.data.size());
+
+    std::vector<char> chunk(CHUNK_SIZE);
+    std::size_t filled = 0;
+
+    // address of the instruction following the previous one, if in the input
+    std::uint32_t expected = UINT32_MAX;
+
+    auto const on_line = [&] (char const* line, std::size_t length)
+    {
+        std::optional<std::uint32_t> const address = parse_trace_address(line, length);
+
+        if (!address)
+            return;
+
+        if (!main_block.contains(*address))
+        {
+            expected = UINT32_MAX;
+            return;
+        }
+
+        std::size_t const index = *address - main_block.address;
+
+        if (*address != expected)
+            arrivals[index] = 1;
+
+        Instr const instr { main_block.data[index], 0 };
+        expected = *address + get_instr_size(instr);
+    };
+
+    while (input)
+    {
+        input.read(chunk.data() + filled, chunk.size() - filled);
+        filled += input.gcount();
+
+        std::size_t line_start = 0;
+
+        for (std::size_t i = 0; i < filled; ++i)
+        {
+            if (chunk[i] != '\n')
+                continue;
+
+            on_line(chunk.data() + line_start, i - line_start);
+            line_start = i + 1;
+        }
+
+        if (line_start == 0 && filled == chunk.size())
+        {
+            // line longer than a chunk: the address is at the start, look at what we have
+
+            on_line(chunk.data(), filled);
+            line_start = filled;
+
+            // skip the rest of the line
+            input.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        }
+
+        std::memmove(chunk.data(), chunk.data() + line_start, filled - line_start);
+        filled -= line_start;
+    }
+
+    if (filled != 0)
+        on_line(chunk.data(), filled);
+
+    for (std::size_t i = 0; i < arrivals.size(); ++i)
+    {
+        if (arrivals[i])
+            result.code_points.push_back(main_block.address + i);
+    }
+
+    return result;
+}
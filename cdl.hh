@@ -0,0 +1,22 @@
+
+#pragma once
+
+#include "common.hh"
+#include "disasm.hh"
+
+#include <istream>
+
+struct CodeDataHints
+{
+    // known instruction starts (sorted)
+    std::vector<std::uint32_t> code_points;
+
+    // known data (sorted, no overlaps)
+    std::vector<AddressBlock> data_blocks;
+};
+
+// FCEUX or Mesen code/data logger file. `offset` is where the first byte of the input is in the log.
+CodeDataHints read_cdl(std::istream& input, DataBlock const& main_block, std::size_t offset);
+
+// Emulator trace log: one executed instruction per line, starting with its address
+CodeDataHints read_trace_log(std::istream& input, DataBlock const& main_block);
@@ -0,0 +1,792 @@
+
+#include "constprop.hh"
+
+#include <array>
+
+namespace
+{
+
+// pointer bytes followed at once, JMP (ind) through others stays unresolved
+constexpr std::size_t MAX_CELLS = 4;
+
+// pushed bytes remembered
+constexpr std::size_t STACK_SIZE = 4;
+
+// visits of a block before what enters it is given up on, which bounds the time spent going around loops
+constexpr unsigned MAX_VISITS = 8;
+
+// a jump resolving to more targets than this is guesswork
+constexpr std::size_t MAX_TARGETS = 64;
+
+// operations between two values are worked out for at most this many pairs of their possible values
+constexpr std::size_t MAX_PAIRS = 1024;
+
+constexpr std::uint32_t NONE = UINT32_MAX;
+
+// Possible values of a byte
+struct ByteSet
+{
+    std::array<std::uint64_t, 4> words;
+
+    static ByteSet none() { return { { 0, 0, 0, 0 } }; }
+    static ByteSet all() { return { { ~0ull, ~0ull, ~0ull, ~0ull } }; }
+
+    static ByteSet one(std::uint8_t value)
+    {
+        ByteSet result = none();
+        result.add(value);
+
+        return result;
+    }
+
+    void add(std::uint8_t value) { words[value >> 6] |= std::uint64_t(1) << (value & 63); }
+    bool has(std::uint8_t value) const { return (words[value >> 6] >> (value & 63)) & 1; }
+
+    bool empty() const { return (words[0] | words[1] | words[2] | words[3]) == 0; }
+    bool full() const { return (words[0] & words[1] & words[2] & words[3]) == ~0ull; }
+
+    std::size_t count() const
+    {
+        return __builtin_popcountll(words[0]) + __builtin_popcountll(words[1]) + __builtin_popcountll(words[2]) + __builtin_popcountll(words[3]);
+    }
+
+    template<typename Func>
+    void for_each(Func func) const
+    {
+        for (std::size_t i = 0; i < 4; ++i)
+        {
+            for (std::uint64_t word = words[i]; word != 0; word &= word - 1)
+                func(static_cast<std::uint8_t>(i * 64 + __builtin_ctzll(word)));
+        }
+    }
+
+    template<typename Pred>
+    ByteSet filter(Pred pred) const
+    {
+        ByteSet result = none();
+
+        for_each([&] (std::uint8_t value)
+        {
+            if (pred(value))
+                result.add(value);
+        });
+
+        return result;
+    }
+
+    bool operator == (ByteSet const& other) const { return words == other.words; }
+    bool operator != (ByteSet const& other) const { return words != other.words; }
+
+    ByteSet& operator |= (ByteSet const& other)
+    {
+        for (std::size_t i = 0; i < 4; ++i)
+            words[i] |= other.words[i];
+
+        return *this;
+    }
+};
+
+// Possible values of a byte, and where they come from when that's a table of the main block: `table` plus each of
+// `index`. Bytes read from two tables with the same index are paired entry by entry rather than every way.
+struct Value
+{
+    ByteSet bits;
+    std::uint32_t table;
+    ByteSet index;
+
+    static Value of(ByteSet const& bits) { return { bits, NONE, ByteSet::none() }; }
+    static Value unknown() { return of(ByteSet::all()); }
+    static Value constant(std::uint8_t value) { return of(ByteSet::one(value)); }
+
+    // returns whether anything changed
+    bool join(Value const& other)
+    {
+        Value const before = *this;
+
+        bits |= other.bits;
+
+        if (table == other.table)
+            index |= other.index;
+        else
+        {
+            table = NONE;
+            index = ByteSet::none();
+        }
+
+        return bits != before.bits || table != before.table || index != before.index;
+    }
+};
+
+enum struct Reg : std::uint8_t
+{
+    None,
+    A,
+    X,
+    Y,
+};
+
+struct State
+{
+    Value a;
+    Value x;
+    Value y;
+
+    std::array<Value, MAX_CELLS> cells;
+
+    // the last bytes pushed, the top one at stack[depth - 1]
+    std::array<Value, STACK_SIZE> stack;
+    std::uint8_t depth;
+
+    // possible carries: bit 0 clear, bit 1 set
+    std::uint8_t carry;
+
+    // what the flags were last set by comparing with, for branches to refine (Reg::None: something else)
+    Reg compared;
+    std::uint8_t compared_value;
+
+    static State unknown()
+    {
+        State result;
+
+        result.a = result.x = result.y = Value::unknown();
+        result.cells.fill(Value::unknown());
+        result.stack.fill(Value::unknown());
+        result.depth = 0;
+        result.carry = 3;
+        result.compared = Reg::None;
+        result.compared_value = 0;
+
+        return result;
+    }
+
+    Value& reg(Reg which)
+    {
+        return (which == Reg::X) ? x : (which == Reg::Y) ? y : a;
+    }
+
+    void push(Value const& value)
+    {
+        if (depth == STACK_SIZE)
+        {
+            std::copy(stack.begin() + 1, stack.end(), stack.begin());
+            depth--;
+        }
+
+        stack[depth++] = value;
+    }
+
+    Value pop()
+    {
+        return (depth != 0) ? stack[--depth] : Value::unknown();
+    }
+
+    // returns whether anything changed, only the first `cell_count` cells being in use
+    bool join(State const& other, std::size_t cell_count)
+    {
+        bool changed = false;
+
+        changed |= a.join(other.a);
+        changed |= x.join(other.x);
+        changed |= y.join(other.y);
+
+        for (std::size_t i = 0; i < cell_count; ++i)
+            changed |= cells[i].join(other.cells[i]);
+
+        // only the pushes both know about, lined up on the top of the stack
+        if (other.depth < depth)
+        {
+            std::copy(stack.begin() + (depth - other.depth), stack.begin() + depth, stack.begin());
+            depth = other.depth;
+            changed = true;
+        }
+
+        for (std::size_t i = 0; i < depth; ++i)
+            changed |= stack[i].join(other.stack[other.depth - depth + i]);
+
+        if ((carry | other.carry) != carry)
+        {
+            carry |= other.carry;
+            changed = true;
+        }
+
+        if (compared != Reg::None && (compared != other.compared || compared_value != other.compared_value))
+        {
+            compared = Reg::None;
+            changed = true;
+        }
+
+        return changed;
+    }
+};
+
+template<typename Func>
+Value map_value(Value const& value, Func func)
+{
+    ByteSet result = ByteSet::none();
+    value.bits.for_each([&] (std::uint8_t v) { result.add(func(v)); });
+
+    return Value::of(result);
+}
+
+// func(l, r, carry) for every pair of possible values, and carry. `bijective`: func takes any l to a different result
+// for given r and carry, so that l being unknown leaves the result unknown.
+template<typename Func>
+Value combine_values(Value const& l, Value const& r, std::uint8_t carry, bool bijective, Func func)
+{
+    if ((bijective && l.bits.full()) || l.bits.count() * r.bits.count() > MAX_PAIRS)
+        return Value::unknown();
+
+    ByteSet result = ByteSet::none();
+
+    l.bits.for_each([&] (std::uint8_t lv)
+    {
+        r.bits.for_each([&] (std::uint8_t rv)
+        {
+            for (std::uint8_t c = 0; c < 2; ++c)
+            {
+                if (carry & (1 << c))
+                    result.add(func(lv, rv, c));
+            }
+        });
+    });
+
+    return Value::of(result);
+}
+
+// adding to a value that could be anything leaves it that way
+Value add_value(Value const& value, std::uint8_t delta)
+{
+    if (value.bits.full())
+        return Value::unknown();
+
+    return map_value(value, [&] (std::uint8_t v) { return std::uint8_t(v + delta); });
+}
+
+struct Propagation
+{
+    AnalConfig const& anal;
+
+    // addresses of the pointer bytes followed (outside the main block, whose bytes are constants)
+    std::vector<std::uint32_t> cells;
+
+    std::size_t find_cell(std::uint32_t address) const
+    {
+        auto const it = std::find(cells.begin(), cells.end(), address);
+        return (it == cells.end()) ? NONE : it - cells.begin();
+    }
+
+    std::uint8_t byte_at(std::uint32_t address) const
+    {
+        return anal.main_block.data[address - anal.main_block.address];
+    }
+
+    Value load(State const& state, std::uint32_t address) const
+    {
+        std::size_t const cell = find_cell(address);
+
+        if (cell != NONE)
+            return state.cells[cell];
+
+        if (anal.main_block.contains(address))
+            return Value::constant(byte_at(address));
+
+        return Value::unknown();
+    }
+
+    Value load_indexed(State const& state, std::uint32_t base, Value const& index, bool zero_page) const
+    {
+        if (!zero_page && !anal.main_block.contains(base) && cells.empty())
+            return Value::unknown();
+
+        ByteSet result = ByteSet::none();
+        bool known = true;
+        bool from_table = !zero_page;
+
+        index.bits.for_each([&] (std::uint8_t i)
+        {
+            std::uint32_t const address = zero_page ? ((base + i) & 0xFF) : (base + i);
+            std::size_t const cell = find_cell(address);
+
+            if (cell != NONE)
+            {
+                result |= state.cells[cell].bits;
+                from_table = false;
+            }
+            else if (anal.main_block.contains(address))
+                result.add(byte_at(address));
+            else
+                known = false;
+        });
+
+        if (!known)
+            return Value::unknown();
+
+        Value value = Value::of(result);
+
+        if (from_table)
+        {
+            value.table = base;
+            value.index = index.bits;
+        }
+
+        return value;
+    }
+
+    Value operand_value(State const& state, Instr const& instr, OpInfo const& info) const
+    {
+        switch (info.addressing_mode)
+        {
+
+        case Am::IMM:
+            return Value::constant(instr.operand);
+
+        case Am::ZRP:
+        case Am::ABS:
+            return load(state, instr.operand);
+
+        case Am::ZRX:
+        case Am::ABX:
+            return load_indexed(state, instr.operand, state.x, info.addressing_mode == Am::ZRX);
+
+        case Am::ZRY:
+        case Am::ABY:
+            return load_indexed(state, instr.operand, state.y, info.addressing_mode == Am::ZRY);
+
+        default:
+            return Value::unknown();
+
+        }
+    }
+
+    void store(State& state, Instr const& instr, OpInfo const& info, Value const& value) const
+    {
+        switch (info.addressing_mode)
+        {
+
+        case Am::ZRP:
+        case Am::ABS:
+        {
+            std::size_t const cell = find_cell(instr.operand);
+
+            if (cell != NONE)
+                state.cells[cell] = value;
+
+            break;
+        }
+
+        case Am::ZRX:
+        case Am::ZRY:
+        case Am::ABX:
+        case Am::ABY:
+        {
+            bool const zero_page = info.addressing_mode == Am::ZRX || info.addressing_mode == Am::ZRY;
+            Value const& index = (info.addressing_mode == Am::ZRX || info.addressing_mode == Am::ABX) ? state.x : state.y;
+
+            // cells the store may or may not hit
+            for (std::size_t i = 0; i < cells.size(); ++i)
+            {
+                std::uint32_t const offset = cells[i] - instr.operand;
+
+                if (zero_page ? (cells[i] < 0x100 && index.bits.has(offset & 0xFF)) : (offset < 0x100 && index.bits.has(offset)))
+                    state.cells[i].join(value);
+            }
+
+            break;
+        }
+
+        default:
+            // through a pointer: anywhere
+            for (std::size_t i = 0; i < cells.size(); ++i)
+                state.cells[i] = Value::unknown();
+
+            break;
+
+        }
+    }
+
+    void step(State& state, Instr const& instr, OpInfo const& info) const
+    {
+        bool keeps_flags = false;
+
+        Reg compared = Reg::None;
+
+        switch (info.mnemonic)
+        {
+
+        case Mnem::LDA: state.a = operand_value(state, instr, info); break;
+        case Mnem::LDX: state.x = operand_value(state, instr, info); break;
+        case Mnem::LDY: state.y = operand_value(state, instr, info); break;
+
+        case Mnem::STA: store(state, instr, info, state.a); keeps_flags = true; break;
+        case Mnem::STX: store(state, instr, info, state.x); keeps_flags = true; break;
+        case Mnem::STY: store(state, instr, info, state.y); keeps_flags = true; break;
+
+        case Mnem::TAX: state.x = state.a; break;
+        case Mnem::TAY: state.y = state.a; break;
+        case Mnem::TXA: state.a = state.x; break;
+        case Mnem::TYA: state.a = state.y; break;
+        case Mnem::TSX: state.x = Value::unknown(); break;
+        case Mnem::TXS: state.depth = 0; keeps_flags = true; break;
+
+        case Mnem::INX: state.x = add_value(state.x, 1); break;
+        case Mnem::DEX: state.x = add_value(state.x, 0xFF); break;
+        case Mnem::INY: state.y = add_value(state.y, 1); break;
+        case Mnem::DEY: state.y = add_value(state.y, 0xFF); break;
+
+        case Mnem::INC: store(state, instr, info, add_value(operand_value(state, instr, info), 1)); break;
+        case Mnem::DEC: store(state, instr, info, add_value(operand_value(state, instr, info), 0xFF)); break;
+
+        case Mnem::AND:
+            state.a = combine_values(state.a, operand_value(state, instr, info), 1, false, [] (std::uint8_t l, std::uint8_t r, std::uint8_t) { return l & r; });
+            break;
+
+        case Mnem::ORA:
+            state.a = combine_values(state.a, operand_value(state, instr, info), 1, false, [] (std::uint8_t l, std::uint8_t r, std::uint8_t) { return l | r; });
+            break;
+
+        case Mnem::EOR:
+            state.a = combine_values(state.a, operand_value(state, instr, info), 1, true, [] (std::uint8_t l, std::uint8_t r, std::uint8_t) { return l ^ r; });
+            break;
+
+        case Mnem::ADC:
+            state.a = combine_values(state.a, operand_value(state, instr, info), state.carry, true, [] (std::uint8_t l, std::uint8_t r, std::uint8_t c) { return l + r + c; });
+            state.carry = 3;
+            break;
+
+        case Mnem::SBC:
+            state.a = combine_values(state.a, operand_value(state, instr, info), state.carry, true, [] (std::uint8_t l, std::uint8_t r, std::uint8_t c) { return l + std::uint8_t(~r) + c; });
+            state.carry = 3;
+            break;
+
+        case Mnem::ASL:
+        case Mnem::LSR:
+        case Mnem::ROL:
+        case Mnem::ROR:
+        {
+            Mnem const mnemonic = info.mnemonic;
+
+            // the carry shifted in only matters to rotations
+            std::uint8_t const carry = (mnemonic == Mnem::ROL || mnemonic == Mnem::ROR) ? state.carry : 1;
+
+            auto const shift = [&] (Value const& value)
+            {
+                return combine_values(value, Value::constant(0), carry, false, [&] (std::uint8_t v, std::uint8_t, std::uint8_t c)
+                {
+                    switch (mnemonic)
+                    {
+
+                    case Mnem::ASL: return std::uint8_t(v << 1);
+                    case Mnem::LSR: return std::uint8_t(v >> 1);
+                    case Mnem::ROL: return std::uint8_t((v << 1) | c);
+                    default: return std::uint8_t((v >> 1) | (c << 7));
+
+                    }
+                });
+            };
+
+            if (info.addressing_mode == Am::ACC)
+                state.a = shift(state.a);
+            else
+                store(state, instr, info, shift(operand_value(state, instr, info)));
+
+            state.carry = 3;
+            break;
+        }
+
+        case Mnem::CMP:
+        case Mnem::CPX:
+        case Mnem::CPY:
+            if (info.addressing_mode == Am::IMM)
+            {
+                compared = (info.mnemonic == Mnem::CMP) ? Reg::A : (info.mnemonic == Mnem::CPX) ? Reg::X : Reg::Y;
+                state.compared_value = instr.operand;
+            }
+
+            state.carry = 3;
+            break;
+
+        case Mnem::CLC: state.carry = 1; break;
+        case Mnem::SEC: state.carry = 2; break;
+
+        case Mnem::PHA: state.push(state.a); keeps_flags = true; break;
+        case Mnem::PHP: state.push(Value::unknown()); keeps_flags = true; break;
+        case Mnem::PLA: state.a = state.pop(); break;
+        case Mnem::PLP: state.pop(); state.carry = 3; break;
+
+        // the callee may change anything, and return anywhere
+        case Mnem::JSR:
+        case Mnem::BRK:
+            state = State::unknown();
+            break;
+
+        case Mnem::NOP:
+        case Mnem::SEI:
+        case Mnem::CLI:
+        case Mnem::SED:
+        case Mnem::CLD:
+        case Mnem::CLV:
+        case Mnem::JMP:
+        case Mnem::BCC:
+        case Mnem::BCS:
+        case Mnem::BEQ:
+        case Mnem::BNE:
+        case Mnem::BMI:
+        case Mnem::BPL:
+        case Mnem::BVC:
+        case Mnem::BVS:
+            keeps_flags = true;
+            break;
+
+        default:
+            break;
+
+        }
+
+        if (compared != Reg::None)
+            state.compared = compared;
+        else if (!keeps_flags)
+            state.compared = Reg::None;
+    }
+
+    // Keeps the values for which a branch is taken, or not. Returns whether that can happen at all.
+    bool refine(State& state, Mnem mnemonic, bool taken) const
+    {
+        if (state.compared == Reg::None)
+            return true;
+
+        std::uint8_t const compared_value = state.compared_value;
+
+        auto const holds = [&] (std::uint8_t v)
+        {
+            switch (mnemonic)
+            {
+
+            case Mnem::BEQ: return (v == compared_value) == taken;
+            case Mnem::BNE: return (v != compared_value) == taken;
+            case Mnem::BCS: return (v >= compared_value) == taken;
+            case Mnem::BCC: return (v < compared_value) == taken;
+            default: return true;
+
+            }
+        };
+
+        Value& value = state.reg(state.compared);
+
+        value.bits = value.bits.filter(holds);
+
+        if (value.table != NONE)
+            value.index = value.index.filter([&] (std::uint8_t i) { return holds(byte_at(value.table + i)); });
+
+        return !value.bits.empty();
+    }
+
+    // Addresses made of the possible low and high bytes, plus `offset`
+    void add_targets(Value const& lo, Value const& hi, std::uint32_t offset, std::vector<std::uint32_t>& result) const
+    {
+        if (lo.table != NONE && hi.table != NONE && lo.index == hi.index)
+        {
+            if (lo.index.count() > MAX_TARGETS)
+                return;
+
+            lo.index.for_each([&] (std::uint8_t i)
+            {
+                result.push_back(((byte_at(lo.table + i) | (byte_at(hi.table + i) << 8)) + offset) & 0xFFFF);
+            });
+
+            return;
+        }
+
+        if (lo.bits.count() * hi.bits.count() > MAX_TARGETS)
+            return;
+
+        lo.bits.for_each([&] (std::uint8_t l)
+        {
+            hi.bits.for_each([&] (std::uint8_t h) { result.push_back(((l | (h << 8)) + offset) & 0xFFFF); });
+        });
+    }
+};
+
+}
+
+// JMP (ind) reads its high byte from the same page
+static std::uint32_t pointer_high_byte(std::uint32_t pointer)
+{
+    return (pointer & 0xFF00) | ((pointer + 1) & 0xFF);
+}
+
+std::vector<std::uint32_t> resolve_indirect_targets(AnalConfig const& anal, FlowGraph const& graph)
+{
+    std::vector<std::uint32_t> result;
+
+    Propagation propagation { anal, {} };
+
+    for (FlowBlock const& block : graph.blocks)
+    {
+        if (block.last_info->mnemonic != Mnem::JMP || block.last_info->addressing_mode != Am::IAB)
+            continue;
+
+        for (std::uint32_t address : { block.target, pointer_high_byte(block.target) })
+        {
+            if (!anal.main_block.contains(address) && propagation.cells.size() < MAX_CELLS && propagation.find_cell(address) == NONE)
+                propagation.cells.push_back(address);
+        }
+    }
+
+    std::size_t const count = graph.blocks.size();
+
+    // Blocks entered from places not in the graph start out knowing nothing: routines, and the targets of unresolved
+    // jumps. Those with predecessors may be such targets too, which is found out when they aren't reached otherwise.
+
+    std::vector<bool> roots(count, false);
+    std::vector<bool> entered(count, false);
+
+    for (FlowBlock const& block : graph.blocks)
+    {
+        if ((block.last_info->flags & OpInfo::FLAG_CALL) && block.jump != FlowGraph::NONE)
+            roots[block.jump] = true;
+        else if (block.jump != FlowGraph::NONE)
+            entered[block.jump] = true;
+
+        if (block.next != FlowGraph::NONE)
+            entered[block.next] = true;
+    }
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        auto const symbols = symbols_at(anal.symbols, graph.blocks[i].start);
+
+        for (auto it = symbols.first; it != symbols.second; ++it)
+        {
+            if (it->flags & Symbol::FLAG_EXEC)
+                roots[i] = true;
+        }
+    }
+
+    std::vector<State> states(count);
+    std::vector<bool> reached(count, false);
+    std::vector<bool> queued(count, false);
+    std::vector<unsigned> visits(count, 0);
+    std::vector<std::size_t> worklist;
+
+    auto const enqueue = [&] (std::size_t i, State const& state)
+    {
+        if (i == FlowGraph::NONE)
+            return;
+
+        if (!reached[i])
+        {
+            states[i] = state;
+            reached[i] = true;
+        }
+        else if (roots[i] || !states[i].join(state, propagation.cells.size()))
+            return;
+
+        if (++visits[i] > MAX_VISITS)
+            states[i] = State::unknown();
+
+        if (!queued[i])
+        {
+            queued[i] = true;
+            worklist.push_back(i);
+        }
+    };
+
+    auto const run = [&] ()
+    {
+        while (!worklist.empty())
+        {
+            std::size_t const i = worklist.back();
+            FlowBlock const& block = graph.blocks[i];
+
+            worklist.pop_back();
+            queued[i] = false;
+
+            State state = states[i];
+
+            for_each_flow_instr(anal, block, [&] ([[maybe_unused]] std::uint32_t addr, Instr const& instr, OpInfo const& info)
+            {
+                propagation.step(state, instr, info);
+            });
+
+            OpInfo const& info = *block.last_info;
+
+            // callees are roots
+            if (info.flags & OpInfo::FLAG_CALL)
+            {
+                enqueue(block.next, state);
+                continue;
+            }
+
+            if (info.addressing_mode == Am::REL)
+            {
+                State taken = state;
+
+                if (propagation.refine(taken, info.mnemonic, true))
+                    enqueue(block.jump, taken);
+
+                if (propagation.refine(state, info.mnemonic, false))
+                    enqueue(block.next, state);
+
+                continue;
+            }
+
+            enqueue(block.next, state);
+            enqueue(block.jump, state);
+        }
+    };
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (roots[i] || !entered[i])
+            enqueue(i, State::unknown());
+    }
+
+    run();
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (!reached[i])
+        {
+            enqueue(i, State::unknown());
+            run();
+        }
+    }
+
+    // the states are final, so are the targets
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        FlowBlock const& block = graph.blocks[i];
+        OpInfo const& info = *block.last_info;
+
+        bool const indirect_jump = info.mnemonic == Mnem::JMP && info.addressing_mode == Am::IAB;
+
+        if (!indirect_jump && info.mnemonic != Mnem::RTS)
+            continue;
+
+        State state = states[i];
+
+        for_each_flow_instr(anal, block, [&] ([[maybe_unused]] std::uint32_t addr, Instr const& instr, OpInfo const& info)
+        {
+            propagation.step(state, instr, info);
+        });
+
+        if (indirect_jump)
+        {
+            Value const lo = propagation.load(state, block.target);
+            Value const hi = propagation.load(state, pointer_high_byte(block.target));
+
+            propagation.add_targets(lo, hi, 0, result);
+        }
+        else if (state.depth >= 2)
+        {
+            // RTS returns to the address pushed, plus one
+            propagation.add_targets(state.stack[state.depth - 1], state.stack[state.depth - 2], 1, result);
+        }
+    }
+
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+
+    return result;
+}
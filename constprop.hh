@@ -0,0 +1,12 @@
+
+#pragma once
+
+#include "common.hh"
+#include "anal.hh"
+#include "flow.hh"
+
+// Where the JMP (ind) and the RTS of `graph` go, when constant propagation tells (sorted). The possible values of A, X,
+// Y, the pointers JMP (ind) goes through and the last few bytes pushed are followed along the graph, bytes of the main
+// block being constants. Compares refine the values down the branches after them, and pointers loaded from two tables
+// with the same index are paired entry by entry. Targets aren't checked for being code.
+std::vector<std::uint32_t> resolve_indirect_targets(AnalConfig const& anal, FlowGraph const& graph);
@@ -0,0 +1,320 @@
+
+#include "diff.hh"
+
+#include <unordered_map>
+
+namespace
+{
+
+// instructions hashed at once: shorter windows match by chance, longer ones miss code changed every few instructions
+constexpr std::size_t WINDOW_SIZE = 8;
+
+// bytes that have to be the same where a data symbol is moved along with the code around it
+constexpr std::uint32_t DATA_CHECK_SIZE = 4;
+
+// farthest a data symbol may be from what matched code points at to be moved along with it
+constexpr std::uint32_t MAX_DATA_OFFSET = 0x100;
+
+constexpr std::uint32_t NONE = UINT32_MAX;
+
+// Instructions of all code blocks, in address order
+struct InstrStream
+{
+    std::vector<std::uint32_t> addresses;
+    std::vector<Instr> instrs;
+
+    // opcode and operand, the latter zeroed if it points inside the image and relative if it's a branch target
+    std::vector<std::uint32_t> tokens;
+};
+
+bool points_inside(DataBlock const& block, OpInfo const& info, Instr const& instr)
+{
+    switch (info.addressing_mode)
+    {
+
+    case Am::ABS:
+    case Am::ABX:
+    case Am::ABY:
+    case Am::IAB:
+        return block.contains(instr.operand);
+
+    default:
+        return false;
+
+    }
+}
+
+InstrStream build_stream(DataBlock const& block, std::vector<AddressBlock> const& code)
+{
+    InstrStream result;
+
+    for (AddressBlock const& code_block : code)
+    {
+        for_each_instr(block.bytes(code_block), code_block, [&] (std::uint32_t addr, Instr const& instr)
+        {
+            OpInfo const* const info = find_opcode_info(instr.opcode);
+
+            std::uint32_t token = instr.opcode;
+
+            if (info != nullptr && info->addressing_mode == Am::REL)
+                token |= ((instr.operand - addr) & 0xFFFF) << 8;
+            else if (info != nullptr && points_inside(block, *info, instr))
+                token |= 1 << 24;
+            else
+                token |= instr.operand << 8;
+
+            result.addresses.push_back(addr);
+            result.instrs.push_back(instr);
+            result.tokens.push_back(token);
+        });
+    }
+
+    return result;
+}
+
+// Polynomial hash of each window of tokens (result[i]: that of tokens i to i + WINDOW_SIZE - 1), updated as the window
+// rolls along
+std::vector<std::uint64_t> hash_windows(std::vector<std::uint32_t> const& tokens)
+{
+    constexpr std::uint64_t BASE = 0x100000001B3;
+
+    std::vector<std::uint64_t> result;
+
+    if (tokens.size() < WINDOW_SIZE)
+        return result;
+
+    result.reserve(tokens.size() - WINDOW_SIZE + 1);
+
+    // weight of the token leaving the window
+    std::uint64_t top = 1;
+
+    for (std::size_t i = 1; i < WINDOW_SIZE; ++i)
+        top *= BASE;
+
+    auto const mix = [] (std::uint32_t token) { return (token + 1) * 0x9E3779B97F4A7C15; };
+
+    std::uint64_t hash = 0;
+
+    for (std::size_t i = 0; i < tokens.size(); ++i)
+    {
+        if (i >= WINDOW_SIZE)
+            hash -= mix(tokens[i - WINDOW_SIZE]) * top;
+
+        hash = hash * BASE + mix(tokens[i]);
+
+        if (i + 1 >= WINDOW_SIZE)
+            result.push_back(hash);
+    }
+
+    return result;
+}
+
+// For each old instruction, the index of the matching new one, or NONE. Windows found exactly once in both streams
+// anchor the alignment, which is then extended both ways as long as the instructions match.
+std::vector<std::uint32_t> align_streams(InstrStream const& old_stream, InstrStream const& new_stream)
+{
+    struct Occurrences
+    {
+        std::uint32_t old_count;
+        std::uint32_t new_count;
+        std::uint32_t old_index;
+        std::uint32_t new_index;
+    };
+
+    std::vector<std::uint64_t> const old_hashes = hash_windows(old_stream.tokens);
+    std::vector<std::uint64_t> const new_hashes = hash_windows(new_stream.tokens);
+
+    std::unordered_map<std::uint64_t, Occurrences> occurrences;
+    occurrences.reserve(old_hashes.size());
+
+    for (std::uint32_t i = 0; i < old_hashes.size(); ++i)
+    {
+        Occurrences& entry = occurrences[old_hashes[i]];
+
+        entry.old_count++;
+        entry.old_index = i;
+    }
+
+    for (std::uint32_t i = 0; i < new_hashes.size(); ++i)
+    {
+        auto const it = occurrences.find(new_hashes[i]);
+
+        if (it == occurrences.end())
+            continue;
+
+        it->second.new_count++;
+        it->second.new_index = i;
+    }
+
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> anchors;
+
+    for (auto const& [hash, entry] : occurrences)
+    {
+        if (entry.old_count == 1 && entry.new_count == 1)
+            anchors.emplace_back(entry.old_index, entry.new_index);
+    }
+
+    std::sort(anchors.begin(), anchors.end());
+
+    std::vector<std::uint32_t> const& old_tokens = old_stream.tokens;
+    std::vector<std::uint32_t> const& new_tokens = new_stream.tokens;
+
+    std::vector<std::uint32_t> result(old_tokens.size(), NONE);
+    std::vector<bool> new_matched(new_tokens.size(), false);
+
+    // each instruction is matched at most once, and scanned at most twice more: linear in the end
+    for (auto [old_index, new_index] : anchors)
+    {
+        if (result[old_index] != NONE || new_matched[new_index])
+            continue;
+
+        while (old_index > 0 && new_index > 0 && result[old_index - 1] == NONE && !new_matched[new_index - 1] &&
+            old_tokens[old_index - 1] == new_tokens[new_index - 1])
+        {
+            old_index--;
+            new_index--;
+        }
+
+        while (old_index < old_tokens.size() && new_index < new_tokens.size() && result[old_index] == NONE &&
+            !new_matched[new_index] && old_tokens[old_index] == new_tokens[new_index])
+        {
+            result[old_index] = new_index;
+            new_matched[new_index] = true;
+
+            old_index++;
+            new_index++;
+        }
+    }
+
+    return result;
+}
+
+// over `size` bytes, clipped to the blocks
+bool same_bytes(DataBlock const& old_block, std::uint32_t old_address, DataBlock const& new_block, std::uint32_t new_address,
+    std::uint32_t size)
+{
+    if (!new_block.contains(new_address))
+        return false;
+
+    for (std::uint32_t i = 0; i < size; ++i)
+    {
+        if (!old_block.contains(old_address + i) || !new_block.contains(new_address + i))
+            break;
+
+        if (old_block.data[old_address + i - old_block.address] != new_block.data[new_address + i - new_block.address])
+            return false;
+    }
+
+    return true;
+}
+
+}
+
+std::vector<Symbol> transfer_symbols(DataBlock const& old_block, std::vector<AddressBlock> const& old_code,
+    DataBlock const& new_block, std::vector<AddressBlock> const& new_code, std::vector<Symbol> const& symbols, Log const& log)
+{
+    InstrStream const old_stream = build_stream(old_block, old_code);
+    InstrStream const new_stream = build_stream(new_block, new_code);
+
+    std::vector<std::uint32_t> const matches = align_streams(old_stream, new_stream);
+
+    // old to new address of each matched instruction (sorted by the former), and of what their operands point at
+
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> moved_instrs;
+    std::unordered_map<std::uint32_t, std::uint32_t> moved_targets;
+
+    for (std::size_t i = 0; i < matches.size(); ++i)
+    {
+        if (matches[i] == NONE)
+            continue;
+
+        moved_instrs.emplace_back(old_stream.addresses[i], new_stream.addresses[matches[i]]);
+
+        Instr const& old_instr = old_stream.instrs[i];
+        Instr const& new_instr = new_stream.instrs[matches[i]];
+        OpInfo const* const info = find_opcode_info(old_instr.opcode);
+
+        if (info == nullptr || !points_inside(old_block, *info, old_instr) || !points_inside(new_block, *info, new_instr))
+            continue;
+
+        auto const [it, inserted] = moved_targets.emplace(old_instr.operand, new_instr.operand);
+
+        // matched code disagreeing on where something went
+        if (!inserted && it->second != new_instr.operand)
+            it->second = NONE;
+    }
+
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> sorted_targets;
+
+    for (auto const& [old_target, new_target] : moved_targets)
+    {
+        if (new_target != NONE)
+            sorted_targets.emplace_back(old_target, new_target);
+    }
+
+    std::sort(sorted_targets.begin(), sorted_targets.end());
+
+    log << "Matched " << moved_instrs.size() << " of " << old_stream.addresses.size() << " instructions to "
+        << new_stream.addresses.size() << " in the new image" << std::endl;
+
+    std::vector<Symbol> result;
+    std::size_t moved_count = 0;
+
+    for (Symbol const& symbol : symbols)
+    {
+        if (!old_block.contains(symbol.value))
+        {
+            result.push_back(symbol);
+            continue;
+        }
+
+        std::uint32_t address = NONE;
+
+        auto const next = std::lower_bound(moved_instrs.begin(), moved_instrs.end(), std::make_pair(symbol.value, std::uint32_t(0)));
+        auto const target = moved_targets.find(symbol.value);
+
+        if (next != moved_instrs.end() && next->first == symbol.value)
+            address = next->second;
+        else if (target != moved_targets.end())
+            address = target->second;
+        else if (next != moved_instrs.begin() && next != moved_instrs.end())
+        {
+            // between matched code that moved as one
+            auto const prev = std::prev(next);
+            std::uint32_t const delta = prev->second - prev->first;
+
+            if (next->second - next->first == delta && same_bytes(old_block, symbol.value, new_block, symbol.value + delta, DATA_CHECK_SIZE))
+                address = symbol.value + delta;
+        }
+
+        if (address == NONE)
+        {
+            // inside data matched code points at, if it's the same up to the symbol
+            auto const start = std::upper_bound(sorted_targets.begin(), sorted_targets.end(), std::make_pair(symbol.value, NONE));
+
+            if (start != sorted_targets.begin())
+            {
+                auto const [old_start, new_start] = *std::prev(start);
+                std::uint32_t const offset = symbol.value - old_start;
+
+                if (offset <= MAX_DATA_OFFSET && same_bytes(old_block, old_start, new_block, new_start, offset + DATA_CHECK_SIZE))
+                    address = new_start + offset;
+            }
+        }
+
+        if (address == NONE)
+        {
+            log << "Lost symbol " << symbol.name << " at " << hex_string<4>(symbol.value) << std::endl;
+            continue;
+        }
+
+        result.push_back({ symbol.name, address, symbol.flags });
+        moved_count++;
+    }
+
+    log << "Moved " << moved_count << " symbol(s), lost " << (symbols.size() - result.size()) << std::endl;
+
+    std::stable_sort(result.begin(), result.end(), Symbol::Compare {});
+
+    return result;
+}
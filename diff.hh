@@ -0,0 +1,12 @@
+
+#pragma once
+
+#include "common.hh"
+#include "anal.hh"
+
+// Moves `symbols` (sorted) of an old version of an image to where what they name went in a new version, given the
+// code blocks found in both. Code is aligned on its instructions, with operands pointing inside the image ignored so
+// that shifted code still matches. Data symbols follow the operands of matched code, or the code around them.
+// Symbols outside the old image are kept as they are, those that can't be placed are dropped. Returns them sorted.
+std::vector<Symbol> transfer_symbols(DataBlock const& old_block, std::vector<AddressBlock> const& old_code,
+    DataBlock const& new_block, std::vector<AddressBlock> const& new_code, std::vector<Symbol> const& symbols, Log const& log);
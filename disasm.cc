@@ -34,6 +34,14 @@ bool address_blocks_contain(std::vector<AddressBlock> const& blocks, std::uint32
 std::vector<AddressBlock> inverted_blocks(AddressBlock const& range, std::vector<AddressBlock> const& blocks)
 {
     std::vector<AddressBlock> result;
+    inverted_blocks(range, blocks, result);
+
+    return result;
+}
+
+void inverted_blocks(AddressBlock const& range, std::vector<AddressBlock> const& blocks, std::vector<AddressBlock>& result)
+{
+    result.clear();
 
     std::uint32_t start = range.start;
 
@@ -55,11 +63,39 @@ std::vector<AddressBlock> inverted_blocks(AddressBlock const& range, std::vector
 
         result.push_back({ new_start, new_size });
     }
+}
+
+std::vector<AddressBlock> subtract_blocks(std::vector<AddressBlock> const& ranges, std::vector<AddressBlock> const& blocks)
+{
+    // Assumes both are sorted and have no overlaps
+
+    std::vector<AddressBlock> result;
+
+    std::size_t i = 0;
+
+    for (AddressBlock const& range : ranges)
+    {
+        std::uint32_t start = range.start;
+        std::uint32_t const end = range.start + range.size;
+
+        while (i < blocks.size() && blocks[i].start + blocks[i].size <= start)
+            i++;
+
+        for (std::size_t j = i; j < blocks.size() && blocks[j].start < end; ++j)
+        {
+            if (blocks[j].start > start)
+                result.push_back({ start, blocks[j].start - start });
+
+            start = std::max(start, blocks[j].start + blocks[j].size);
+        }
+
+        if (start < end)
+            result.push_back({ start, end - start });
+    }
 
     return result;
 }
 
-
 Instr decode_instr_operand(std::size_t addr, std::uint8_t opcode, ByteScanner& input)
 {
     Instr result;
@@ -48,6 +48,8 @@ struct DataBlock
 bool address_blocks_contain(std::vector<AddressBlock> const& blocks, std::uint32_t address);
 
 std::vector<AddressBlock> inverted_blocks(AddressBlock const& range, std::vector<AddressBlock> const& blocks);
+void inverted_blocks(AddressBlock const& range, std::vector<AddressBlock> const& blocks, std::vector<AddressBlock>& result);
+std::vector<AddressBlock> subtract_blocks(std::vector<AddressBlock> const& ranges, std::vector<AddressBlock> const& blocks);
 
 Instr decode_instr_operand(std::size_t addr, std::uint8_t opcode, ByteScanner& input);
 Instr decode_instruction(std::size_t addr, ByteScanner& input);
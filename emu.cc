@@ -0,0 +1,669 @@
+
+#include "emu.hh"
+
+#include <chrono>
+#include <memory>
+namespace
+{
+
+enum : byte_type
+{
+    STATUS_C = (1 << 0),
+    STATUS_Z = (1 << 1),
+    STATUS_I = (1 << 2),
+    STATUS_D = (1 << 3),
+    STATUS_B = (1 << 4),
+    STATUS_U = (1 << 5),
+    STATUS_V = (1 << 6),
+    STATUS_N = (1 << 7),
+};
+
+constexpr std::uint16_t VECTOR_NMI   = 0xFFFA;
+constexpr std::uint16_t VECTOR_RESET = 0xFFFC;
+constexpr std::uint16_t VECTOR_IRQ   = 0xFFFE;
+
+}
+
+Emulator::Emulator(DataBlock const& main_block, std::vector<Segment> const& segments)
+{
+    for (std::uint32_t addr = 0; addr < 0x10000; ++addr)
+    {
+        bool const loaded = main_block.contains(addr);
+
+        if (loaded)
+            m_memory[addr] = main_block.data[addr - main_block.address];
+
+        std::uint8_t flags = 0;
+
+        for (Segment const& segment : segments)
+        {
+            if (!segment.contains(addr))
+                continue;
+
+            flags = segment.flags;
+            break;
+        }
+
+        if (flags & Segment::FLAG_VOLATILE)
+            m_kind[addr] = PAGE_VOLATILE;
+        else if (flags & Segment::FLAG_WRITE)
+            m_kind[addr] = PAGE_MEMORY;
+        else if (loaded)
+            m_kind[addr] = PAGE_READONLY;
+        else
+            m_kind[addr] = PAGE_VOLATILE;
+    }
+
+    for (unsigned page = 0; page < 0x100; ++page)
+    {
+        auto const first = m_kind.begin() + page * 0x100;
+        bool const uniform = std::all_of(first, first + 0x100, [&] (std::uint8_t kind) { return kind == *first; });
+
+        if (!uniform)
+        {
+            m_read_pages[page] = PAGE_MIXED;
+            m_write_pages[page] = PAGE_MIXED;
+            continue;
+        }
+
+        m_read_pages[page] = (*first == PAGE_READONLY) ? std::uint8_t(PAGE_MEMORY) : *first;
+        m_write_pages[page] = *first;
+    }
+
+    for (unsigned opcode = 0; opcode < 0x100; ++opcode)
+    {
+        OpInfo const* const info = find_opcode_info(opcode);
+
+        if (info != nullptr)
+            m_ops[opcode] = { info->mnemonic, info->addressing_mode, info->flags, info->cycles, true };
+    }
+
+    m_has_vectors = main_block.contains(VECTOR_NMI) && main_block.contains(VECTOR_IRQ + 1);
+}
+
+byte_type Emulator::read_slow(std::uint16_t addr)
+{
+    if (m_kind[addr] != PAGE_VOLATILE)
+        return m_memory[addr];
+
+    // Unpredictable values, so that code polling hardware eventually moves on
+
+    m_noise ^= m_noise << 13;
+    m_noise ^= m_noise >> 17;
+    m_noise ^= m_noise << 5;
+
+    return m_noise;
+}
+
+void Emulator::write_slow(std::uint16_t addr, byte_type value)
+{
+    if (m_kind[addr] == PAGE_MEMORY)
+        m_memory[addr] = value;
+}
+
+byte_type Emulator::get_status(bool brk) const
+{
+    return (m_n ? STATUS_N : 0)
+        | (m_v ? STATUS_V : 0)
+        | STATUS_U
+        | (brk ? STATUS_B : 0)
+        | (m_d ? STATUS_D : 0)
+        | (m_i ? STATUS_I : 0)
+        | (m_z ? STATUS_Z : 0)
+        | (m_c ? STATUS_C : 0);
+}
+
+void Emulator::set_status(byte_type value)
+{
+    m_n = value & STATUS_N;
+    m_z = value & STATUS_Z;
+    m_v = value & STATUS_V;
+    m_d = value & STATUS_D;
+    m_i = value & STATUS_I;
+    m_c = value & STATUS_C;
+}
+
+void Emulator::interrupt(std::uint16_t vector, bool brk)
+{
+    push(m_pc >> 8);
+    push(m_pc & 0xFF);
+    push(get_status(brk));
+
+    m_i = true;
+    m_pc = read_word(vector);
+}
+
+void Emulator::reset()
+{
+    m_s = 0xFD;
+    m_i = true;
+    m_jammed = false;
+    m_pc = read_word(VECTOR_RESET);
+}
+
+void Emulator::nmi()
+{
+    interrupt(VECTOR_NMI, false);
+    m_cycles += 7;
+}
+
+void Emulator::irq()
+{
+    if (m_i)
+        return;
+
+    interrupt(VECTOR_IRQ, false);
+    m_cycles += 7;
+}
+
+template<typename Observer>
+void Emulator::run(std::uint64_t cycles, Observer& observer)
+{
+    std::uint64_t const end = m_cycles + cycles;
+
+    while (m_cycles < end)
+    {
+        std::uint16_t const pc = m_pc;
+        OpEntry const op = m_ops[read(pc)];
+
+        if (!op.valid)
+        {
+            m_jammed = true;
+            return;
+        }
+
+        unsigned cycles = op.cycles;
+
+        // Step 1. effective address
+
+        std::uint16_t addr = 0;
+        std::uint16_t next = pc + 1;
+
+        auto const index = [&] (std::uint16_t base, byte_type offset)
+        {
+            std::uint16_t const result = base + offset;
+
+            // stores and read-modify-writes have the penalty built in
+            if (((result ^ base) & 0xFF00) && !(op.flags & OpInfo::FLAG_WRITE))
+                cycles++;
+
+            return result;
+        };
+
+        switch (op.addressing_mode)
+        {
+
+        case Am::IMP:
+        case Am::ACC:
+            break;
+
+        case Am::IMM:
+            addr = next++;
+            break;
+
+        case Am::ZRP:
+            addr = read(next++);
+            break;
+
+        case Am::ZRX:
+            addr = (read(next++) + m_x) & 0xFF;
+            break;
+
+        case Am::ZRY:
+            addr = (read(next++) + m_y) & 0xFF;
+            break;
+
+        case Am::ABS:
+            addr = read_word(next);
+            next += 2;
+            break;
+
+        case Am::ABX:
+            addr = index(read_word(next), m_x);
+            next += 2;
+            break;
+
+        case Am::ABY:
+            addr = index(read_word(next), m_y);
+            next += 2;
+            break;
+
+        case Am::IAB:
+        {
+            std::uint16_t const ptr = read_word(next);
+            next += 2;
+
+            // the high byte doesn't carry over to the next page
+            addr = read(ptr) | (read((ptr & 0xFF00) | ((ptr + 1) & 0xFF)) << 8);
+
+            break;
+        }
+
+        case Am::INX:
+        {
+            byte_type const ptr = read(next++) + m_x;
+            addr = read(ptr) | (read((ptr + 1) & 0xFF) << 8);
+            break;
+        }
+
+        case Am::INY:
+        {
+            byte_type const ptr = read(next++);
+            addr = index(read(ptr) | (read((ptr + 1) & 0xFF) << 8), m_y);
+            break;
+        }
+
+        case Am::REL:
+        {
+            std::int8_t const offset = read(next++);
+            addr = next + offset;
+            break;
+        }
+
+        }
+
+        m_pc = next;
+
+        // Step 2. operation
+
+        auto const set_nz = [&] (byte_type value) -> byte_type
+        {
+            m_n = value & 0x80;
+            m_z = value == 0;
+            return value;
+        };
+
+        auto const branch = [&] (bool taken)
+        {
+            if (!taken)
+                return;
+
+            cycles += ((addr ^ m_pc) & 0xFF00) ? 2 : 1;
+            m_pc = addr;
+        };
+
+        auto const compare = [&] (byte_type reg)
+        {
+            byte_type const value = read(addr);
+
+            m_c = reg >= value;
+            set_nz(reg - value);
+        };
+
+        auto const adc = [&] (byte_type value)
+        {
+            unsigned result = m_a + value + m_c;
+
+            if (m_d)
+            {
+                unsigned lo = (m_a & 0x0F) + (value & 0x0F) + m_c;
+                unsigned hi = (m_a & 0xF0) + (value & 0xF0);
+
+                if (lo > 0x09)
+                    lo += 0x06;
+
+                if (lo > 0x0F)
+                    hi += 0x10;
+
+                m_v = ~(m_a ^ value) & (m_a ^ hi) & 0x80;
+
+                if (hi > 0x90)
+                    hi += 0x60;
+
+                m_c = hi > 0xFF;
+                m_a = set_nz((hi & 0xF0) | (lo & 0x0F));
+
+                return;
+            }
+
+            m_v = ~(m_a ^ value) & (m_a ^ result) & 0x80;
+            m_c = result > 0xFF;
+            m_a = set_nz(result);
+        };
+
+        auto const sbc = [&] (byte_type value)
+        {
+            if (m_d)
+            {
+                int lo = (m_a & 0x0F) - (value & 0x0F) - !m_c;
+                int hi = (m_a & 0xF0) - (value & 0xF0);
+
+                if (lo < 0)
+                {
+                    lo -= 0x06;
+                    hi -= 0x10;
+                }
+
+                unsigned const binary = m_a - value - !m_c;
+
+                m_v = (m_a ^ value) & (m_a ^ binary) & 0x80;
+                m_c = binary < 0x100;
+
+                if (hi < 0)
+                    hi -= 0x60;
+
+                m_a = set_nz((hi & 0xF0) | (lo & 0x0F));
+
+                return;
+            }
+
+            adc(~value);
+        };
+
+        // read-modify-write on either A or memory
+        auto const modify = [&] (auto func)
+        {
+            if (op.addressing_mode == Am::ACC)
+            {
+                m_a = set_nz(func(m_a));
+                return;
+            }
+
+            write(addr, set_nz(func(read(addr))));
+        };
+
+        switch (op.mnemonic)
+        {
+
+        case Mnem::ADC: adc(read(addr)); break;
+        case Mnem::SBC: sbc(read(addr)); break;
+        case Mnem::AND: m_a = set_nz(m_a & read(addr)); break;
+        case Mnem::ORA: m_a = set_nz(m_a | read(addr)); break;
+        case Mnem::EOR: m_a = set_nz(m_a ^ read(addr)); break;
+
+        case Mnem::ASL: modify([&] (byte_type v) -> byte_type { m_c = v & 0x80; return v << 1; }); break;
+        case Mnem::LSR: modify([&] (byte_type v) -> byte_type { m_c = v & 0x01; return v >> 1; }); break;
+        case Mnem::ROL: modify([&] (byte_type v) -> byte_type { bool const c = m_c; m_c = v & 0x80; return (v << 1) | c; }); break;
+        case Mnem::ROR: modify([&] (byte_type v) -> byte_type { bool const c = m_c; m_c = v & 0x01; return (v >> 1) | (c << 7); }); break;
+        case Mnem::INC: modify([&] (byte_type v) -> byte_type { return v + 1; }); break;
+        case Mnem::DEC: modify([&] (byte_type v) -> byte_type { return v - 1; }); break;
+
+        case Mnem::BCC: branch(!m_c); break;
+        case Mnem::BCS: branch(m_c); break;
+        case Mnem::BNE: branch(!m_z); break;
+        case Mnem::BEQ: branch(m_z); break;
+        case Mnem::BPL: branch(!m_n); break;
+        case Mnem::BMI: branch(m_n); break;
+        case Mnem::BVC: branch(!m_v); break;
+        case Mnem::BVS: branch(m_v); break;
+
+        case Mnem::BIT:
+        {
+            byte_type const value = read(addr);
+
+            m_n = value & 0x80;
+            m_v = value & 0x40;
+            m_z = (m_a & value) == 0;
+
+            break;
+        }
+
+        case Mnem::BRK:
+            m_pc = pc + 2;
+            interrupt(VECTOR_IRQ, true);
+            break;
+
+        case Mnem::CLC: m_c = false; break;
+        case Mnem::CLD: m_d = false; break;
+        case Mnem::CLI: m_i = false; break;
+        case Mnem::CLV: m_v = false; break;
+        case Mnem::SEC: m_c = true; break;
+        case Mnem::SED: m_d = true; break;
+        case Mnem::SEI: m_i = true; break;
+
+        case Mnem::CMP: compare(m_a); break;
+        case Mnem::CPX: compare(m_x); break;
+        case Mnem::CPY: compare(m_y); break;
+
+        case Mnem::DEX: m_x = set_nz(m_x - 1); break;
+        case Mnem::DEY: m_y = set_nz(m_y - 1); break;
+        case Mnem::INX: m_x = set_nz(m_x + 1); break;
+        case Mnem::INY: m_y = set_nz(m_y + 1); break;
+
+        case Mnem::JMP:
+            if (op.addressing_mode == Am::IAB)
+                observer.on_indirect(addr);
+
+            m_pc = addr;
+            break;
+
+        case Mnem::JSR:
+            push((m_pc - 1) >> 8);
+            push((m_pc - 1) & 0xFF);
+            m_pc = addr;
+            break;
+
+        case Mnem::LDA: m_a = set_nz(read(addr)); break;
+        case Mnem::LDX: m_x = set_nz(read(addr)); break;
+        case Mnem::LDY: m_y = set_nz(read(addr)); break;
+
+        case Mnem::NOP: break;
+
+        case Mnem::PHA: push(m_a); break;
+        case Mnem::PHP: push(get_status(true)); break;
+        case Mnem::PLA: m_a = set_nz(pull()); break;
+        case Mnem::PLP: set_status(pull()); break;
+
+        case Mnem::RTI:
+        {
+            set_status(pull());
+
+            byte_type const lo = pull();
+            byte_type const hi = pull();
+
+            m_pc = lo | (hi << 8);
+
+            break;
+        }
+
+        case Mnem::RTS:
+        {
+            byte_type const lo = pull();
+            byte_type const hi = pull();
+
+            m_pc = (lo | (hi << 8)) + 1;
+
+            break;
+        }
+
+        case Mnem::STA: write(addr, m_a); break;
+        case Mnem::STX: write(addr, m_x); break;
+        case Mnem::STY: write(addr, m_y); break;
+
+        case Mnem::TAX: m_x = set_nz(m_a); break;
+        case Mnem::TAY: m_y = set_nz(m_a); break;
+        case Mnem::TSX: m_x = set_nz(m_s); break;
+        case Mnem::TXA: m_a = set_nz(m_x); break;
+        case Mnem::TXS: m_s = m_x; break;
+        case Mnem::TYA: m_a = set_nz(m_y); break;
+
+        }
+
+        m_cycles += cycles;
+
+        observer.on_instr(pc, cycles);
+
+        if (m_pc != next)
+            observer.on_arrival(m_pc);
+    }
+}
+
+namespace
+{
+
+struct DiscoveryObserver
+{
+    std::vector<std::uint8_t> executed = std::vector<std::uint8_t>(0x10000);
+    std::vector<std::uint8_t> arrivals = std::vector<std::uint8_t>(0x10000);
+    std::vector<std::uint8_t> indirect = std::vector<std::uint8_t>(0x10000);
+
+    // profiled along, if not null
+    EmuProfile* profile = nullptr;
+
+    std::uint64_t instructions = 0;
+
+    void on_instr(std::uint16_t pc, unsigned cycles)
+    {
+        executed[pc] = 1;
+        instructions++;
+
+        if (profile != nullptr)
+        {
+            profile->executions[pc]++;
+            profile->cycles[pc] += cycles;
+        }
+    }
+
+    void on_arrival(std::uint16_t pc)
+    {
+        arrivals[pc] = 1;
+    }
+
+    void on_indirect(std::uint16_t target)
+    {
+        indirect[target] = 1;
+    }
+};
+
+struct ProfileObserver
+{
+    EmuProfile& profile;
+
+    std::uint64_t instructions = 0;
+
+    void on_instr(std::uint16_t pc, unsigned cycles)
+    {
+        profile.executions[pc]++;
+        profile.cycles[pc] += cycles;
+        instructions++;
+    }
+
+    void on_arrival([[maybe_unused]] std::uint16_t pc) {}
+    void on_indirect([[maybe_unused]] std::uint16_t target) {}
+};
+
+}
+
+// Returns false if emulation couldn't start
+template<typename Observer>
+static bool emulate(AnalConfig const& anal, EmuConfig const& config, Observer& observer)
+{
+    // too big for the stack
+    std::unique_ptr<Emulator> const emu_ptr = std::make_unique<Emulator>(anal.main_block, anal.segments);
+    Emulator& emu = *emu_ptr;
+
+    if (!emu.has_vectors())
+    {
+        anal.log << "Emulation skipped: interrupt vectors aren't part of the input." << std::endl;
+        return false;
+    }
+
+    auto const start_time = std::chrono::steady_clock::now();
+
+    emu.reset();
+    observer.on_arrival(emu.pc());
+
+    std::uint32_t const half_frame = config.frame_cycles / 2;
+
+    auto const done = [&] ()
+    {
+        if (emu.jammed())
+            return true;
+
+        return config.max_instructions != 0 && observer.instructions >= config.max_instructions;
+    };
+
+    for (std::uint32_t frame = 0; frame < config.frames && !done(); ++frame)
+    {
+        emu.run(half_frame, observer);
+
+        if (done())
+            break;
+
+        emu.irq();
+        observer.on_arrival(emu.pc());
+
+        emu.run(config.frame_cycles - half_frame, observer);
+
+        if (done())
+            break;
+
+        emu.nmi();
+        observer.on_arrival(emu.pc());
+    }
+
+    auto const end_time = std::chrono::steady_clock::now();
+    double const seconds = std::chrono::duration<double>(end_time - start_time).count();
+
+    if (emu.jammed())
+        anal.log << "Emulation stopped: CPU jammed at " << hex_string<4>(emu.pc()) << std::endl;
+
+    anal.log << "Emulated " << observer.instructions << " instructions (" << emu.cycles() << " cycles) in " << seconds << "s ("
+        << (observer.instructions / std::max(seconds, 1e-9) / 1e6) << "M/s)" << std::endl;
+
+    return true;
+}
+
+static void init_profile(EmuProfile& profile)
+{
+    profile.executions.assign(0x10000, 0);
+    profile.cycles.assign(0x10000, 0);
+    profile.total_cycles = 0;
+}
+
+static void total_profile(EmuProfile& profile)
+{
+    for (std::uint64_t cycles : profile.cycles)
+        profile.total_cycles += cycles;
+}
+
+EmuDiscovery discover_code_by_emulation(AnalConfig const& anal, EmuConfig const& config, EmuProfile* profile)
+{
+    EmuDiscovery result {};
+    DiscoveryObserver observer;
+
+    if (profile != nullptr)
+    {
+        init_profile(*profile);
+        observer.profile = profile;
+    }
+
+    bool const emulated = emulate(anal, config, observer);
+
+    if (profile != nullptr)
+        total_profile(*profile);
+
+    if (!emulated)
+        return result;
+
+    for (std::uint32_t addr = 0; addr < 0x10000; ++addr)
+    {
+        if (!anal.main_block.contains(addr) || !observer.executed[addr])
+            continue;
+
+        if (observer.arrivals[addr])
+            result.code_points.push_back(addr);
+
+        if (observer.indirect[addr])
+            result.indirect_targets.push_back(addr);
+    }
+
+    result.instructions = observer.instructions;
+
+    anal.log << "Emulation found " << result.code_points.size() << " code points." << std::endl;
+
+    return result;
+}
+
+EmuProfile profile_by_emulation(AnalConfig const& anal, EmuConfig const& config)
+{
+    EmuProfile result {};
+    init_profile(result);
+
+    ProfileObserver observer { result };
+
+    emulate(anal, config, observer);
+    total_profile(result);
+
+    return result;
+}
@@ -0,0 +1,142 @@
+
+#pragma once
+
+#include "common.hh"
+#include "6502.hh"
+#include "anal.hh"
+
+#include <array>
+
+struct EmuConfig
+{
+    std::uint32_t frames;
+
+    // an NMI is raised at the end of each frame, an IRQ half way through (if not masked)
+    std::uint32_t frame_cycles;
+
+    // stop early (at the next half frame) once this many instructions ran (0: no limit)
+    std::uint64_t max_instructions;
+};
+
+struct Emulator
+{
+    Emulator(DataBlock const& main_block, std::vector<Segment> const& segments);
+
+    bool has_vectors() const { return m_has_vectors; }
+    std::uint16_t pc() const { return m_pc; }
+    bool jammed() const { return m_jammed; }
+    std::uint64_t cycles() const { return m_cycles; }
+
+    void reset();
+    void nmi();
+    void irq();
+
+    // Runs until at least `cycles` more cycles have elapsed, or the CPU jams.
+    // Defined (and instantiated) in emu.cc. Observer must provide:
+    //   on_instr(std::uint16_t pc, unsigned cycles)
+    //   on_arrival(std::uint16_t pc)       (control got here other than by falling through)
+    //   on_indirect(std::uint16_t target)  (JMP (ind) target)
+    template<typename Observer>
+    void run(std::uint64_t cycles, Observer& observer);
+
+private:
+    enum : std::uint8_t
+    {
+        PAGE_MEMORY,   // plain memory
+        PAGE_VOLATILE, // hardware registers, unmapped: reads are unpredictable, writes are dropped
+        PAGE_READONLY, // writes are dropped
+        PAGE_MIXED,    // look at m_kind
+    };
+
+    struct OpEntry
+    {
+        Mnem mnemonic;
+        Am addressing_mode;
+        std::uint8_t flags;
+        std::uint8_t cycles;
+        bool valid;
+    };
+
+    byte_type read(std::uint16_t addr)
+    {
+        if (m_read_pages[addr >> 8] == PAGE_MEMORY)
+            return m_memory[addr];
+
+        return read_slow(addr);
+    }
+
+    void write(std::uint16_t addr, byte_type value)
+    {
+        if (m_write_pages[addr >> 8] == PAGE_MEMORY)
+            m_memory[addr] = value;
+        else
+            write_slow(addr, value);
+    }
+
+    byte_type read_slow(std::uint16_t addr);
+    void write_slow(std::uint16_t addr, byte_type value);
+
+    std::uint16_t read_word(std::uint16_t addr)
+    {
+        return read(addr) | (read(addr + 1) << 8);
+    }
+
+    void push(byte_type value)
+    {
+        m_memory[0x100 | m_s] = value;
+        m_s--;
+    }
+
+    byte_type pull()
+    {
+        m_s++;
+        return m_memory[0x100 | m_s];
+    }
+
+    byte_type get_status(bool brk) const;
+    void set_status(byte_type value);
+
+    void interrupt(std::uint16_t vector, bool brk);
+
+    std::array<byte_type, 0x10000> m_memory {};
+    std::array<std::uint8_t, 0x10000> m_kind {};
+    std::array<std::uint8_t, 0x100> m_read_pages {};
+    std::array<std::uint8_t, 0x100> m_write_pages {};
+    std::array<OpEntry, 0x100> m_ops {};
+
+    std::uint16_t m_pc = 0;
+    byte_type m_a = 0, m_x = 0, m_y = 0, m_s = 0xFD;
+
+    bool m_n = false, m_z = false, m_c = false, m_v = false, m_i = true, m_d = false;
+
+    bool m_jammed = false;
+    bool m_has_vectors = false;
+
+    std::uint32_t m_noise = 0x2545F491;
+    std::uint64_t m_cycles = 0;
+};
+
+struct EmuDiscovery
+{
+    // addresses control got to by something else than falling through (sorted)
+    std::vector<std::uint32_t> code_points;
+
+    // targets of executed indirect jumps (sorted)
+    std::vector<std::uint32_t> indirect_targets;
+
+    std::uint64_t instructions;
+};
+
+struct EmuProfile
+{
+    // per address, indexed by address
+    std::vector<std::uint64_t> executions;
+    std::vector<std::uint64_t> cycles;
+
+    std::uint64_t total_cycles;
+};
+
+// `profile`, if given, is filled from the same run, as profile_by_emulation would
+EmuDiscovery discover_code_by_emulation(AnalConfig const& anal, EmuConfig const& config, EmuProfile* profile = nullptr);
+
+EmuProfile profile_by_emulation(AnalConfig const& anal, EmuConfig const& config);
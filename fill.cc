@@ -0,0 +1,57 @@
+
+#include "fill.hh"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+std::vector<AddressBlock> find_fill_runs(DataBlock const& block, std::size_t min_length)
+{
+    std::vector<AddressBlock> result;
+
+    byte_type const* const data = block.data.data();
+    std::size_t const size = block.data.size();
+
+    if (size == 0)
+        return result;
+
+    std::size_t run_start = 0;
+
+    // a run ends where a byte differs from the one before it
+    auto const end_run = [&] (std::size_t end)
+    {
+        if (end - run_start >= min_length)
+            result.push_back({ static_cast<std::uint32_t>(block.address + run_start), static_cast<std::uint32_t>(end - run_start) });
+
+        run_start = end;
+    };
+
+    std::size_t i = 1;
+
+#ifdef __SSE2__
+    // each byte against the one before it, 16 at a time
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i const bytes = _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + i));
+        __m128i const previous = _mm_loadu_si128(reinterpret_cast<__m128i const*>(data + i - 1));
+
+        unsigned changes = ~_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, previous)) & 0xFFFF;
+
+        while (changes != 0)
+        {
+            end_run(i + __builtin_ctz(changes));
+            changes &= changes - 1;
+        }
+    }
+#endif
+
+    for (; i < size; ++i)
+    {
+        if (data[i] != data[i - 1])
+            end_run(i);
+    }
+
+    end_run(size);
+
+    return result;
+}
@@ -0,0 +1,10 @@
+
+#pragma once
+
+#include "common.hh"
+#include "disasm.hh"
+
+constexpr std::uint32_t DEFAULT_MIN_FILL_LENGTH = 32;
+
+// Runs of at least `min_length` (> 1) copies of the same byte in `block` (sorted): padding, cleared tables...
+std::vector<AddressBlock> find_fill_runs(DataBlock const& block, std::size_t min_length);
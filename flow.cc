@@ -0,0 +1,102 @@
+
+#include "flow.hh"
+
+std::size_t FlowGraph::find(std::uint32_t address) const
+{
+    auto const it = std::lower_bound(blocks.begin(), blocks.end(), address, [] (FlowBlock const& block, std::uint32_t address)
+    {
+        return block.start < address;
+    });
+
+    if (it == blocks.end() || it->start != address)
+        return NONE;
+
+    return it - blocks.begin();
+}
+
+std::size_t FlowGraph::find_containing(std::uint32_t address) const
+{
+    auto const it = std::upper_bound(blocks.begin(), blocks.end(), address, [] (std::uint32_t address, FlowBlock const& block)
+    {
+        return address < block.start;
+    });
+
+    if (it == blocks.begin() || !(it - 1)->contains(address))
+        return NONE;
+
+    return (it - 1) - blocks.begin();
+}
+
+FlowGraph build_flow_graph(AnalConfig const& anal, std::vector<AddressBlock> const& code_blocks, std::vector<std::uint32_t> const& entries)
+{
+    FlowGraph result;
+
+    std::vector<std::uint32_t> targets;
+
+    list_code_xrefs(anal, code_blocks, targets);
+    targets.insert(targets.end(), entries.begin(), entries.end());
+
+    std::sort(targets.begin(), targets.end());
+    targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+
+    // Step 1. split code blocks at every address something jumps to, or the graph is entered at
+
+    for (AddressBlock const& block : code_blocks)
+    {
+        FlowBlock current {};
+
+        current.start = block.start;
+        current.last_info = nullptr;
+
+        for_each_instr(anal.main_block.bytes(block), block, [&] (std::uint32_t addr, Instr const& instr)
+        {
+            if (addr != current.start && in_sorted_vector(targets, addr))
+            {
+                current.size = addr - current.start;
+                result.blocks.push_back(current);
+
+                current.start = addr;
+            }
+
+            current.last = addr;
+            current.target = instr.operand;
+            current.last_info = get_instr_info(instr, anal);
+        });
+
+        current.size = block.start + block.size - current.start;
+
+        if (current.size != 0 && current.last_info != nullptr)
+            result.blocks.push_back(current);
+    }
+
+    // Step 2. link blocks together
+
+    for (FlowBlock& block : result.blocks)
+    {
+        OpInfo const* const info = block.last_info;
+
+        block.next = FlowGraph::NONE;
+        block.jump = FlowGraph::NONE;
+
+        if (!(info->flags & OpInfo::FLAG_END))
+            block.next = result.find(block.start + block.size);
+
+        if (info->flags & OpInfo::FLAG_JUMP)
+        {
+            switch (info->addressing_mode)
+            {
+
+            case Am::ABS:
+            case Am::REL:
+                block.jump = result.find(block.target);
+                break;
+
+            default:
+                break;
+
+            }
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,47 @@
+
+#pragma once
+
+#include "common.hh"
+#include "6502.hh"
+#include "anal.hh"
+
+struct FlowBlock : public AddressBlock
+{
+    // address of the instruction ending the block
+    std::uint32_t last;
+
+    // operand of the instruction ending the block
+    std::uint32_t target;
+
+    OpInfo const* last_info;
+
+    // index of the block following this one (fallthrough or return from call)
+    std::size_t next;
+
+    // index of the block targeted by the branch, jump or call ending this one
+    std::size_t jump;
+};
+
+struct FlowGraph
+{
+    static constexpr std::size_t NONE = SIZE_MAX;
+
+    // sorted by address, no overlaps
+    std::vector<FlowBlock> blocks;
+
+    std::size_t find(std::uint32_t address) const;
+    std::size_t find_containing(std::uint32_t address) const;
+};
+
+// `entries`: where the graph is entered other than by jumps (vectors...), which start blocks too
+FlowGraph build_flow_graph(AnalConfig const& anal, std::vector<AddressBlock> const& code_blocks,
+    std::vector<std::uint32_t> const& entries = {});
+
+template<typename Func>
+void for_each_flow_instr(AnalConfig const& anal, FlowBlock const& block, Func func)
+{
+    for_each_instr(anal.main_block.bytes(block), block, [&] (std::uint32_t addr, Instr const& instr)
+    {
+        func(addr, instr, *get_instr_info(instr, anal));
+    });
+}
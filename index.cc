@@ -0,0 +1,305 @@
+
+#include "index.hh"
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+void write_index(Analysis const& analysis, std::vector<LineMark> const& line_marks, std::string_view listing_name, std::ostream& output)
+{
+    IndexHeader header {};
+
+    std::memcpy(header.magic, INDEX_MAGIC, sizeof(header.magic));
+    header.version = INDEX_VERSION;
+    header.byte_order = INDEX_BYTE_ORDER;
+    header.base_address = analysis.anal.main_block.address;
+    header.size = analysis.anal.main_block.data.size();
+
+    // Step 1. lay out the sections
+
+    std::vector<IndexBlock> blocks;
+
+    for (AddressBlock const& block : analysis.blocks)
+        blocks.push_back({ block.start, block.size });
+
+    std::string names;
+    std::vector<IndexSymbol> symbols;
+
+    for (Symbol const& symbol : analysis.symbols)
+    {
+        symbols.push_back({ symbol.value, (std::uint32_t) names.size(), (std::uint32_t) symbol.name.size(), symbol.flags, {} });
+        names += symbol.name;
+    }
+
+    header.listing_name_offset = names.size();
+    header.listing_name_size = listing_name.size();
+    names += listing_name;
+
+    std::vector<std::uint32_t> by_name(symbols.size());
+
+    for (std::size_t i = 0; i < by_name.size(); ++i)
+        by_name[i] = i;
+
+    std::stable_sort(by_name.begin(), by_name.end(), [&] (std::uint32_t l, std::uint32_t r)
+    {
+        return analysis.symbols[l].name < analysis.symbols[r].name;
+    });
+
+    std::vector<IndexXref> xrefs;
+
+    for (Xref const& xref : analysis.xrefs.refs)
+        xrefs.push_back({ xref.source, xref.kind, {} });
+
+    // keep the first line of each address (its label, when it has one)
+
+    std::vector<IndexLine> lines;
+
+    for (LineMark const& mark : line_marks)
+        lines.push_back({ mark.address, 0, mark.offset });
+
+    std::stable_sort(lines.begin(), lines.end(), [] (IndexLine const& l, IndexLine const& r)
+    {
+        return l.address < r.address;
+    });
+
+    lines.erase(std::unique(lines.begin(), lines.end(), [] (IndexLine const& l, IndexLine const& r)
+    {
+        return l.address == r.address;
+    }), lines.end());
+
+    std::uint64_t offset = sizeof(IndexHeader);
+
+    auto const place = [&] (IndexSectionId id, std::size_t count, std::size_t element_size)
+    {
+        offset = (offset + 7) & ~std::uint64_t(7);
+
+        header.sections[id] = { offset, count };
+        offset += count * element_size;
+    };
+
+    place(INDEX_BLOCKS, blocks.size(), sizeof(IndexBlock));
+    place(INDEX_SYMBOLS, symbols.size(), sizeof(IndexSymbol));
+    place(INDEX_SYMBOLS_BY_NAME, by_name.size(), sizeof(std::uint32_t));
+    place(INDEX_NAMES, names.size(), sizeof(char));
+    place(INDEX_XREF_TARGETS, analysis.xrefs.targets.size(), sizeof(std::uint32_t));
+    place(INDEX_XREF_OFFSETS, analysis.xrefs.offsets.size(), sizeof(std::uint32_t));
+    place(INDEX_XREFS, xrefs.size(), sizeof(IndexXref));
+    place(INDEX_LINES, lines.size(), sizeof(IndexLine));
+
+    // Step 2. write them
+
+    std::uint64_t written = 0;
+
+    auto const write = [&] (void const* data, std::size_t size)
+    {
+        output.write(static_cast<char const*>(data), size);
+        written += size;
+    };
+
+    auto const write_section = [&] (IndexSectionId id, void const* data, std::size_t size)
+    {
+        static char const padding[8] {};
+
+        write(padding, header.sections[id].offset - written);
+        write(data, size);
+    };
+
+    write(&header, sizeof(header));
+
+    write_section(INDEX_BLOCKS, blocks.data(), blocks.size() * sizeof(IndexBlock));
+    write_section(INDEX_SYMBOLS, symbols.data(), symbols.size() * sizeof(IndexSymbol));
+    write_section(INDEX_SYMBOLS_BY_NAME, by_name.data(), by_name.size() * sizeof(std::uint32_t));
+    write_section(INDEX_NAMES, names.data(), names.size());
+    write_section(INDEX_XREF_TARGETS, analysis.xrefs.targets.data(), analysis.xrefs.targets.size() * sizeof(std::uint32_t));
+    write_section(INDEX_XREF_OFFSETS, analysis.xrefs.offsets.data(), analysis.xrefs.offsets.size() * sizeof(std::uint32_t));
+    write_section(INDEX_XREFS, xrefs.data(), xrefs.size() * sizeof(IndexXref));
+    write_section(INDEX_LINES, lines.data(), lines.size() * sizeof(IndexLine));
+}
+
+IndexView::IndexView(std::string const& file_name)
+{
+    int const fd = ::open(file_name.c_str(), O_RDONLY);
+
+    if (fd < 0)
+        throw IndexError("Couldn't open index file \"" + file_name + "\": " + std::strerror(errno));
+
+    struct stat st;
+
+    if (::fstat(fd, &st) < 0 || st.st_size < (off_t) sizeof(IndexHeader))
+    {
+        ::close(fd);
+        throw IndexError("\"" + file_name + "\" is too small to be an index");
+    }
+
+    void* const data = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (data == MAP_FAILED)
+        throw IndexError("Couldn't map index file \"" + file_name + "\": " + std::strerror(errno));
+
+    m_data = static_cast<char const*>(data);
+    m_size = st.st_size;
+
+    auto const fail = [&] (char const* why)
+    {
+        ::munmap(const_cast<char*>(m_data), m_size);
+        throw IndexError("\"" + file_name + "\" " + why);
+    };
+
+    IndexHeader const& head = header();
+
+    if (std::memcmp(head.magic, INDEX_MAGIC, sizeof(head.magic)) != 0)
+        fail("is not an index");
+
+    if (head.version != INDEX_VERSION)
+        fail("is an index of an unsupported version");
+
+    if (head.byte_order != INDEX_BYTE_ORDER)
+        fail("is an index written on a machine of different byte order");
+
+    std::size_t const element_sizes[INDEX_SECTION_COUNT]
+    {
+        sizeof(IndexBlock),
+        sizeof(IndexSymbol),
+        sizeof(std::uint32_t),
+        sizeof(char),
+        sizeof(std::uint32_t),
+        sizeof(std::uint32_t),
+        sizeof(IndexXref),
+        sizeof(IndexLine),
+    };
+
+    for (std::size_t i = 0; i < INDEX_SECTION_COUNT; ++i)
+    {
+        IndexSection const& section = head.sections[i];
+
+        if (section.offset % 8 != 0 || section.offset > m_size || section.count > (m_size - section.offset) / element_sizes[i])
+            fail("is a truncated or corrupt index");
+    }
+
+    if (std::uint64_t(head.listing_name_offset) + head.listing_name_size > head.sections[INDEX_NAMES].count)
+        fail("is a corrupt index");
+}
+
+IndexView::~IndexView()
+{
+    ::munmap(const_cast<char*>(m_data), m_size);
+}
+
+std::string_view IndexView::name(std::uint32_t offset, std::uint32_t size) const
+{
+    auto const names = section<char>(INDEX_NAMES);
+
+    if (std::uint64_t(offset) + size > std::size_t(names.second - names.first))
+        return {};
+
+    return std::string_view(names.first + offset, size);
+}
+
+IndexSymbol const* IndexView::find_symbol(std::string_view symbol_name) const
+{
+    auto const symbols = section<IndexSymbol>(INDEX_SYMBOLS);
+    auto const by_name = section<std::uint32_t>(INDEX_SYMBOLS_BY_NAME);
+
+    std::size_t const count = symbols.second - symbols.first;
+
+    auto const it = std::lower_bound(by_name.first, by_name.second, symbol_name, [&] (std::uint32_t index, std::string_view value)
+    {
+        return index < count && name(symbols.first[index]) < value;
+    });
+
+    if (it == by_name.second || *it >= count || name(symbols.first[*it]) != symbol_name)
+        return nullptr;
+
+    return symbols.first + *it;
+}
+
+std::pair<IndexSymbol const*, IndexSymbol const*> IndexView::symbols_at(std::uint32_t address) const
+{
+    auto const symbols = section<IndexSymbol>(INDEX_SYMBOLS);
+
+    auto const lo = std::lower_bound(symbols.first, symbols.second, address, [] (IndexSymbol const& l, std::uint32_t r) { return l.value < r; });
+    auto const hi = std::upper_bound(lo, symbols.second, address, [] (std::uint32_t l, IndexSymbol const& r) { return l < r.value; });
+
+    return { lo, hi };
+}
+
+IndexBlock const* IndexView::find_block(std::uint32_t address) const
+{
+    auto const blocks = section<IndexBlock>(INDEX_BLOCKS);
+
+    auto it = std::upper_bound(blocks.first, blocks.second, address, [] (std::uint32_t l, IndexBlock const& r) { return l < r.start; });
+
+    if (it == blocks.first)
+        return nullptr;
+
+    --it;
+
+    return (address - it->start < it->size) ? it : nullptr;
+}
+
+std::pair<IndexXref const*, IndexXref const*> IndexView::xrefs_to(std::uint32_t address) const
+{
+    auto const targets = section<std::uint32_t>(INDEX_XREF_TARGETS);
+    auto const offsets = section<std::uint32_t>(INDEX_XREF_OFFSETS);
+    auto const xrefs = section<IndexXref>(INDEX_XREFS);
+
+    auto const it = std::lower_bound(targets.first, targets.second, address);
+
+    if (it == targets.second || *it != address)
+        return { nullptr, nullptr };
+
+    std::size_t const i = it - targets.first;
+    std::size_t const xref_count = xrefs.second - xrefs.first;
+
+    if (i + 1 >= std::size_t(offsets.second - offsets.first) || offsets.first[i] > offsets.first[i + 1] || offsets.first[i + 1] > xref_count)
+        return { nullptr, nullptr };
+
+    return { xrefs.first + offsets.first[i], xrefs.first + offsets.first[i + 1] };
+}
+
+IndexLine const* IndexView::find_line(std::uint32_t address) const
+{
+    auto const lines = section<IndexLine>(INDEX_LINES);
+
+    auto it = std::upper_bound(lines.first, lines.second, address, [] (std::uint32_t l, IndexLine const& r) { return l < r.address; });
+
+    if (it == lines.first)
+        return nullptr;
+
+    return it - 1;
+}
+
+CountingStreambuf::int_type CountingStreambuf::overflow(int_type ch)
+{
+    if (traits_type::eq_int_type(ch, traits_type::eof()))
+        return traits_type::not_eof(ch);
+
+    m_count++;
+    return m_target->sputc(traits_type::to_char_type(ch));
+}
+
+std::streamsize CountingStreambuf::xsputn(char const* data, std::streamsize count)
+{
+    std::streamsize const written = m_target->sputn(data, count);
+    m_count += written;
+
+    return written;
+}
+
+CountingStreambuf::pos_type CountingStreambuf::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+    // only telling is supported
+    if (off != 0 || dir != std::ios_base::cur || !(which & std::ios_base::out))
+        return pos_type(off_type(-1));
+
+    return pos_type(off_type(m_count));
+}
+
+int CountingStreambuf::sync()
+{
+    return m_target->pubsync();
+}
@@ -0,0 +1,148 @@
+
+#pragma once
+
+#include "common.hh"
+#include "analyzer.hh"
+
+#include <ostream>
+#include <streambuf>
+#include <string_view>
+
+// Binary analysis index. Everything is stored the way it is laid out in memory here, so that a mapped file can be
+// used as is. Sections are 8-byte aligned, their offsets are from the start of the file.
+
+constexpr char INDEX_MAGIC[8] = { 'J', 'U', 'L', 'I', 'D', 'X', 0, 0 };
+constexpr std::uint32_t INDEX_VERSION = 1;
+constexpr std::uint32_t INDEX_BYTE_ORDER = 0x01020304;
+
+enum IndexSectionId : std::uint32_t
+{
+    INDEX_BLOCKS,          // IndexBlock, sorted
+    INDEX_SYMBOLS,         // IndexSymbol, sorted by value
+    INDEX_SYMBOLS_BY_NAME, // std::uint32_t symbol indices, sorted by name
+    INDEX_NAMES,           // char, symbol names and the listing file name (not terminated)
+    INDEX_XREF_TARGETS,    // std::uint32_t, sorted
+    INDEX_XREF_OFFSETS,    // std::uint32_t, one more than targets
+    INDEX_XREFS,           // IndexXref, grouped by target
+    INDEX_LINES,           // IndexLine, sorted by address
+
+    INDEX_SECTION_COUNT,
+};
+
+struct IndexSection
+{
+    std::uint64_t offset;
+    std::uint64_t count;
+};
+
+struct IndexHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+
+    std::uint32_t base_address;
+    std::uint32_t size;
+
+    // in the names section
+    std::uint32_t listing_name_offset;
+    std::uint32_t listing_name_size;
+
+    IndexSection sections[INDEX_SECTION_COUNT];
+};
+
+struct IndexBlock
+{
+    std::uint32_t start;
+    std::uint32_t size;
+};
+
+struct IndexSymbol
+{
+    std::uint32_t value;
+    std::uint32_t name_offset;
+    std::uint32_t name_size;
+    std::uint8_t flags;
+    std::uint8_t reserved[3];
+};
+
+struct IndexXref
+{
+    std::uint32_t source;
+    XrefKind kind;
+    std::uint8_t reserved[3];
+};
+
+struct IndexLine
+{
+    std::uint32_t address;
+    std::uint32_t reserved;
+    std::uint64_t offset;
+};
+
+struct IndexError : public std::runtime_error
+{
+    using std::runtime_error::runtime_error;
+};
+
+// `line_marks` are positions in the listing written to `listing_name` (empty for stdout)
+void write_index(Analysis const& analysis, std::vector<LineMark> const& line_marks, std::string_view listing_name, std::ostream& output);
+
+// Read-only view of a mapped index file. Throws IndexError when the file can't be mapped or isn't a valid index.
+struct IndexView
+{
+    explicit IndexView(std::string const& file_name);
+    ~IndexView();
+
+    IndexView(IndexView const&) = delete;
+    IndexView& operator = (IndexView const&) = delete;
+
+    IndexHeader const& header() const { return *reinterpret_cast<IndexHeader const*>(m_data); }
+
+    template<typename T>
+    std::pair<T const*, T const*> section(IndexSectionId id) const
+    {
+        IndexSection const& section = header().sections[id];
+        T const* const first = reinterpret_cast<T const*>(m_data + section.offset);
+
+        return { first, first + section.count };
+    }
+
+    std::string_view name(std::uint32_t offset, std::uint32_t size) const;
+    std::string_view name(IndexSymbol const& symbol) const { return name(symbol.name_offset, symbol.name_size); }
+
+    // nullptr if none
+    IndexSymbol const* find_symbol(std::string_view name) const;
+
+    // symbols at address
+    std::pair<IndexSymbol const*, IndexSymbol const*> symbols_at(std::uint32_t address) const;
+
+    // code block containing address, nullptr if none
+    IndexBlock const* find_block(std::uint32_t address) const;
+
+    std::pair<IndexXref const*, IndexXref const*> xrefs_to(std::uint32_t address) const;
+
+    // last line at or before address, nullptr if none
+    IndexLine const* find_line(std::uint32_t address) const;
+
+private:
+    char const* m_data = nullptr;
+    std::size_t m_size = 0;
+};
+
+// Counts what goes through it, so that tellp works on any output (including stdout)
+struct CountingStreambuf : public std::streambuf
+{
+    explicit CountingStreambuf(std::streambuf* target)
+        : m_target(target) {}
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(char const* data, std::streamsize count) override;
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+    int sync() override;
+
+private:
+    std::streambuf* m_target;
+    std::uint64_t m_count = 0;
+};
@@ -1,263 +1,547 @@
 
 #include "common.hh"
 #include "csv.hh"
-#include "anal.hh"
-#include "print.hh"
+#include "analyzer.hh"
+#include "diff.hh"
+#include "fill.hh"
+#include "pointers.hh"
+#include "tables.hh"
+#include "batch.hh"
+#include "server.hh"
+#include "index.hh"
+#include "query.hh"
 #include "args.hh"
+#include "alloc.hh"
 
 #include <fstream>
+#include <iostream>
+#include <sstream>
 #include <cstring>
 
-int main(int argc, char** argv)
+template<typename ReadFunc>
+static bool read_table(std::string_view const& file_name_view, char const* what, ReadFunc read_func)
 {
-    Args args = parse_args(argc, argv);
+    std::string const file_name { file_name_view };
+    std::ifstream f(file_name);
 
-    AnalConfig anal {};
+    if (!f.is_open())
+    {
+        std::cerr << "Couldn't open file for read:" << std::endl;
+        std::cerr << "  " << file_name << std::endl;
+        std::cerr << std::endl;
 
-    // Read input data
+        return false;
+    }
 
-    std::ifstream input(std::string { args.input_filename }, std::ios::in | std::ios::binary);
+    try
+    {
+        read_func(f);
+    }
+    catch (CsvError const& e)
+    {
+        std::cerr << "Failed to parse " << what << " file \"" << file_name << "\":" << std::endl;
+        std::cerr << "  " << e.what() << std::endl;
+        std::cerr << std::endl;
 
-    if (!input.is_open())
+        return false;
+    }
+    catch (HexDecodeError const& e)
     {
-        std::cerr << "Couldn't open input file \"" << args.input_filename << "\"" << std::endl;
+        std::cerr << "Failed to parse " << what << " file \"" << file_name << "\":" << std::endl;
+        std::cerr << "  Hex decode error: " << e.what() << std::endl;
         std::cerr << std::endl;
 
-        return 3;
+        return false;
     }
 
-    if (args.input_size == 0)
+    return true;
+}
+
+static bool read_input(InputRange const& range, DataBlock& block, std::ostream& errors)
+{
+    std::ifstream input(range.filename, std::ios::in | std::ios::binary);
+
+    if (!input.is_open())
+    {
+        errors << "Couldn't open input file \"" << range.filename << "\"" << std::endl;
+        errors << std::endl;
+
+        return false;
+    }
+
+    std::size_t size = range.size;
+
+    if (size == 0)
     {
         input.seekg(0, std::ios::end);
-        args.input_size = ((std::size_t) input.tellg()) - args.input_offset;
+        size = ((std::size_t) input.tellg()) - range.offset;
     }
 
-    input.seekg(args.input_offset, std::ios::beg);
+    input.seekg(range.offset, std::ios::beg);
 
-    anal.main_block.address = args.base_address;
-    anal.main_block.data.resize(args.input_size);
+    block.data.resize(size);
 
-    if (!input.read(reinterpret_cast<char*>(anal.main_block.data.data()), anal.main_block.data.size()))
+    if (!input.read(reinterpret_cast<char*>(block.data.data()), block.data.size()))
     {
-        std::cerr << "Failed to read data from input file \"" << args.input_filename << "\"" << std::endl;
-        std::cerr << std::endl;
+        errors << "Failed to read data from input file \"" << range.filename << "\"" << std::endl;
+        errors << std::endl;
 
-        return 3;
+        return false;
     }
 
-    input.close();
+    return true;
+}
+
+// `cdl_offset` is where the first byte of the block is in the code/data log
+static bool read_hints(Args const& args, DataBlock const& main_block, std::size_t cdl_offset, CodeDataHints& hints, std::ostream& errors)
+{
+    auto const add_hints = [&] (CodeDataHints const& more)
+    {
+        hints.code_points.insert(hints.code_points.end(), more.code_points.begin(), more.code_points.end());
 
-    // Read segment table
+        // only code/data logs know about data
+        if (!more.data_blocks.empty())
+            hints.data_blocks = more.data_blocks;
+    };
 
-    if (args.opt_segment_file)
+    if (args.opt_cdl_file)
     {
-        std::string const file_name { *args.opt_segment_file };
-        std::ifstream f(file_name);
+        std::string const file_name { *args.opt_cdl_file };
+        std::ifstream f(file_name, std::ios::in | std::ios::binary);
 
         if (!f.is_open())
         {
-            std::cerr << "Couldn't open file for read:" << std::endl;
-            std::cerr << "  " << file_name << std::endl;
-            std::cerr << std::endl;
+            errors << "Couldn't open file for read:" << std::endl;
+            errors << "  " << file_name << std::endl;
+            errors << std::endl;
 
-            return 3;
+            return false;
         }
 
-        try
+        add_hints(read_cdl(f, main_block, cdl_offset));
+    }
+
+    if (args.opt_trace_file)
+    {
+        std::string const file_name { *args.opt_trace_file };
+        std::ifstream f(file_name, std::ios::in | std::ios::binary);
+
+        if (!f.is_open())
         {
-            Csv csv = Csv::from_stream(f);
+            errors << "Couldn't open file for read:" << std::endl;
+            errors << "  " << file_name << std::endl;
+            errors << std::endl;
 
-            if (csv.field_names.size() != 4)
-                throw CsvError("Bad CSV column count. (Expected 4)");
+            return false;
+        }
 
-            for (Csv::Record const& record : csv.records)
-            {
-                Segment segment {};
+        add_hints(read_trace_log(f, main_block));
+    }
 
-                segment.name = record[0];
-                segment.start = hex_decode<std::uint32_t>(record[1]);
-                segment.size = hex_decode<std::uint32_t>(record[2]);
+    return true;
+}
 
-                for (char c : record[3])
-                {
-                    switch (c)
-                    {
+template<typename PrintFunc>
+static bool write_output(std::optional<std::string_view> const& output_file, std::ostream& errors, PrintFunc do_print)
+{
+    if (!output_file)
+    {
+        do_print(std::cout);
+        return true;
+    }
 
-                    case 'w':
-                        segment.flags |= Segment::FLAG_WRITE;
-                        break;
+    std::string const file_name { *output_file };
+    std::ofstream output(file_name);
 
-                    case 'r':
-                        segment.flags |= Segment::FLAG_READ;
-                        break;
+    if (!output.is_open())
+    {
+        errors << "Couldn't open file for write:" << std::endl;
+        errors << "  " << file_name << std::endl;
+        errors << std::endl;
 
-                    case 'x':
-                        segment.flags |= Segment::FLAG_EXEC;
-                        break;
+        return false;
+    }
 
-                    default:
-                        break;
+    do_print(output);
+    return true;
+}
 
-                    }
-                }
+// `phases`, if given, gets the allocation statistics of each step
+static bool disassemble(Args const& args, Analyzer const& analyzer, InputRange const& input, std::uint32_t base_address,
+    std::optional<std::string_view> const& output_file, std::ostream& errors, Log const& log, AllocPhases* phases = nullptr)
+{
+    auto const phase = [&] (char const* name)
+    {
+        if (phases != nullptr)
+            phases->start(name);
+    };
 
-                anal.segments.push_back(std::move(segment));
-            }
-        }
-        catch (CsvError const& e)
+    phase("input");
+
+    DataBlock main_block { base_address, {} };
+
+    if (!read_input(input, main_block, errors))
+        return false;
+
+    phase("hints");
+
+    CodeDataHints hints;
+
+    if (!read_hints(args, main_block, args.cdl_offset, hints, errors))
+        return false;
+
+    phase("analysis");
+
+    Analysis const analysis = analyzer.analyse(std::move(main_block), hints, log);
+
+    phase("output");
+
+    if (args.record_format)
+    {
+        return write_output(output_file, errors, [&] (std::ostream& output)
         {
-            std::cerr << "Failed to parse segment table file \"" << file_name << "\":" << std::endl;
-            std::cerr << "  " << e.what() << std::endl;
-            std::cerr << std::endl;
+            write_records(*args.record_format, analysis, output);
+        });
+    }
 
-            return 3;
-        }
-        catch (HexDecodeError const& e)
+    if (!args.opt_index_file)
+    {
+        return write_output(output_file, errors, [&] (std::ostream& output)
         {
-            std::cerr << "Failed to parse segment table file \"" << file_name << "\":" << std::endl;
-            std::cerr << "  Hex decode error: " << e.what() << std::endl;
-            std::cerr << std::endl;
+            analyzer.print(analysis, output);
+        });
+    }
 
-            return 3;
-        }
+    std::vector<LineMark> line_marks;
+
+    bool const written = write_output(output_file, errors, [&] (std::ostream& output)
+    {
+        CountingStreambuf counter(output.rdbuf());
+        std::ostream counted(&counter);
+
+        analyzer.print(analysis, counted, &line_marks);
+        counted.flush();
+    });
+
+    if (!written)
+        return false;
+
+    phase("index");
+
+    std::string const file_name { *args.opt_index_file };
+    std::ofstream index(file_name, std::ios::out | std::ios::binary);
+
+    if (!index.is_open())
+    {
+        errors << "Couldn't open file for write:" << std::endl;
+        errors << "  " << file_name << std::endl;
+        errors << std::endl;
+
+        return false;
     }
 
-    // Read symbol table
+    write_index(analysis, line_marks, output_file.value_or(std::string_view {}), index);
+
+    return true;
+}
+
+static bool serve_analysis(Args const& args, Analyzer const& analyzer, std::ostream& errors, Log const& log)
+{
+    DataBlock main_block { args.base_address, {} };
 
-    if (args.opt_symbol_file)
+    if (!read_input(args.input, main_block, errors))
+        return false;
+
+    CodeDataHints hints;
+
+    if (!read_hints(args, main_block, args.cdl_offset, hints, errors))
+        return false;
+
+    Analysis analysis = analyzer.analyse(std::move(main_block), hints, log);
+    Server server(analysis);
+
+    try
+    {
+        serve(server, std::string { *args.opt_socket_file }, log);
+    }
+    catch (std::system_error const& e)
     {
-        std::string const file_name { *args.opt_symbol_file };
-        std::ifstream f(file_name);
+        errors << "Couldn't serve on socket:" << std::endl;
+        errors << "  " << e.what() << std::endl;
+        errors << std::endl;
 
-        if (!f.is_open())
-        {
-            std::cerr << "Couldn't open file for read:" << std::endl;
-            std::cerr << "  " << file_name << std::endl;
-            std::cerr << std::endl;
+        return false;
+    }
 
-            return 3;
-        }
+    return true;
+}
 
-        try
-        {
-            Csv csv = Csv::from_stream(f);
+// The input symbols of the old version are moved to the new one, analysed with only those outside the old image
+static bool diff_inputs(Args const& args, Analyzer const& analyzer, std::ostream& errors, Log const& log)
+{
+    DataBlock old_block { args.base_address, {} };
+    DataBlock new_block { args.base_address, {} };
 
-            if (csv.field_names.size() != 3)
-                throw CsvError("Bad CSV column count. (Expected 3)");
+    if (!read_input(args.input, old_block, errors) || !read_input(*args.opt_diff_input, new_block, errors))
+        return false;
 
-            for (Csv::Record const& record : csv.records)
-            {
-                Symbol symbol {};
+    // code/data logs and traces are of the old version
+    CodeDataHints hints;
 
-                symbol.name = record[0];
-                symbol.value = hex_decode<std::uint32_t>(record[1]);
+    if (!read_hints(args, old_block, args.cdl_offset, hints, errors))
+        return false;
 
-                for (char c : record[2])
-                {
-                    switch (c)
-                    {
+    Analysis const old_analysis = analyzer.analyse(std::move(old_block), hints, log);
+    DataBlock const& old_main = old_analysis.anal.main_block;
 
-                    case 'w':
-                        symbol.flags |= Symbol::FLAG_WRITE;
-                        break;
+    std::vector<Symbol> outside_symbols;
 
-                    case 'r':
-                        symbol.flags |= Symbol::FLAG_READ;
-                        break;
+    std::copy_if(analyzer.symbols().begin(), analyzer.symbols().end(), std::back_inserter(outside_symbols),
+        [&] (Symbol const& symbol) { return !old_main.contains(symbol.value); });
 
-                    case 'x':
-                        symbol.flags |= Symbol::FLAG_EXEC;
-                        break;
+    Analysis const new_analysis = analyzer.analyse(std::move(new_block), outside_symbols, {}, log);
 
-                    default:
-                        break;
+    std::vector<Symbol> const symbols = transfer_symbols(old_main, old_analysis.blocks, new_analysis.anal.main_block,
+        new_analysis.blocks, analyzer.symbols(), log);
 
-                    }
-                }
+    return write_output(args.opt_output_file, errors, [&] (std::ostream& output) { write_symbol_table(symbols, output); });
+}
 
-                anal.symbols.push_back(std::move(symbol));
-            }
-        }
-        catch (CsvError const& e)
+// Fixed banks are analysed first, one after the other. Switchable banks then are analysed in parallel, all of them
+// seeing the symbols of the fixed banks.
+static bool disassemble_banks(Args const& args, Analyzer const& analyzer, std::ostream& errors, Log const& log)
+{
+    std::vector<BankLayout> layout;
+
+    if (!read_table(*args.opt_bank_file, "bank layout", [&] (std::istream& f) { layout = read_bank_layout(f); }))
+        return false;
+
+    DataBlock rom { 0, {} };
+
+    if (!read_input(args.input, rom, errors))
+        return false;
+
+    std::vector<DataBlock> blocks(layout.size());
+    std::vector<CodeDataHints> hints(layout.size());
+
+    for (std::size_t i = 0; i < layout.size(); ++i)
+    {
+        BankLayout const& bank = layout[i];
+
+        if (bank.size == 0 || bank.offset + bank.size > rom.data.size())
         {
-            std::cerr << "Failed to parse symbol table file \"" << file_name << "\":" << std::endl;
-            std::cerr << "  " << e.what() << std::endl;
-            std::cerr << std::endl;
+            errors << "Bank " << bank.name << " is out of the bounds of input file \"" << args.input.filename << "\"" << std::endl;
+            errors << std::endl;
 
-            return 3;
+            return false;
         }
-        catch (HexDecodeError const& e)
-        {
-            std::cerr << "Failed to parse symbol table file \"" << file_name << "\":" << std::endl;
-            std::cerr << "  Hex decode error: " << e.what() << std::endl;
-            std::cerr << std::endl;
 
-            return 3;
+        blocks[i].address = bank.address;
+        blocks[i].data.assign(rom.data.begin() + bank.offset, rom.data.begin() + bank.offset + bank.size);
+
+        if (!read_hints(args, blocks[i], args.cdl_offset + bank.offset, hints[i], errors))
+            return false;
+    }
+
+    std::vector<Analysis> banks(layout.size());
+
+    std::vector<Symbol> fixed_symbols = analyzer.symbols();
+    std::vector<std::size_t> switchable;
+
+    for (std::size_t i = 0; i < layout.size(); ++i)
+    {
+        if (!layout[i].fixed)
+        {
+            switchable.push_back(i);
+            continue;
         }
+
+        banks[i] = analyzer.analyse(std::move(blocks[i]), fixed_symbols, hints[i], log);
+        fixed_symbols = banks[i].symbols;
     }
 
-    // Finish setting up anal
+    parallel_for(switchable.size(), args.jobs, [&] (std::size_t index)
+    {
+        std::size_t const i = switchable[index];
 
-    anal.allow_brk = args.flag_brk;
+        // analysis chatter from many banks at once would be unreadable
+        banks[i] = analyzer.analyse(std::move(blocks[i]), fixed_symbols, hints[i], Log {});
+    });
 
-    if (anal.segments.empty())
-        anal.segments.push_back({ { 0, 0x10000 }, "ALL", Segment::FLAG_READ | Segment::FLAG_WRITE | Segment::FLAG_EXEC });
+    if (analyzer.cache().hits() != 0)
+        log << "Reused analysis of " << analyzer.cache().hits() << " identical bank(s)" << std::endl;
 
-    if (anal.main_block.contains(0xFFFA) && anal.main_block.contains(0xFFFF))
+    return write_output(args.opt_output_file, errors, [&] (std::ostream& output)
     {
-        char const* const vector_value_names[]
+        for (std::size_t i = 0; i < layout.size(); ++i)
         {
-            "ENTRY_NMI",
-            "ENTRY_RESET",
-            "ENTRY_IRQ",
-        };
+            BankLayout const& bank = layout[i];
 
-        for (std::size_t i = 0; i < 3; ++i)
-        {
-            std::uint8_t const lo = anal.main_block.data[0xFFFA - anal.main_block.address + 2*i + 0];
-            std::uint8_t const hi = anal.main_block.data[0xFFFA - anal.main_block.address + 2*i + 1];
+            std::ostringstream header;
 
-            std::uint32_t const val = lo | (hi << 8);
+            header << "/* Bank " << bank.name << (bank.fixed ? " (fixed)" : "")
+                << ": $" << hex_string<4>(bank.size) << " bytes from offset $" << hex_string<6>(bank.offset)
+                << ", mapped at $" << hex_string<4>(bank.address) << " */" << std::endl;
+            header << std::endl;
 
-            anal.symbols.push_back({ vector_value_names[i], val, Symbol::FLAG_EXEC });
+            if (args.syntax == AsmSyntax::Julian)
+                output << header.str();
+            else
+                print_as_line_comments(header.str(), output);
+
+            analyzer.print(banks[i], output);
         }
+    });
+}
+
+// `phases`, if given, gets the allocation statistics of each step
+static int run(Args const& args, AllocPhases* phases)
+{
+    auto const phase = [&] (char const* name)
+    {
+        if (phases != nullptr)
+            phases->start(name);
+    };
+
+    phase("tables");
+
+    // Read segment, symbol and signature tables, shared by all inputs
+
+    std::vector<Segment> segments;
+    std::vector<Symbol> symbols;
+    std::vector<Signature> signatures;
+
+    if (args.opt_segment_file && !read_table(*args.opt_segment_file, "segment table",
+        [&] (std::istream& f) { segments = read_segment_table(f); }))
+    {
+        return 3;
+    }
+
+    if (args.opt_symbol_file && !read_table(*args.opt_symbol_file, "symbol table",
+        [&] (std::istream& f) { symbols = read_symbol_table(f); }))
+    {
+        return 3;
+    }
+
+    if (args.opt_signature_file && !read_table(*args.opt_signature_file, "signature table",
+        [&] (std::istream& f) { signatures = read_signature_table(f); }))
+    {
+        return 3;
     }
 
-    std::sort(anal.symbols.begin(), anal.symbols.end(), Symbol::Compare {});
+    AnalyzerOptions options {};
+
+    options.emulate_frames = args.emulate_frames;
+    options.emulate_instructions = args.emulate_instructions;
+    options.profile_count = args.profile_count;
+    options.min_code_likelihood = args.min_code_likelihood.value_or(DEFAULT_MIN_CODE_LIKELIHOOD);
+    options.min_fill_length = args.min_fill_length.value_or(DEFAULT_MIN_FILL_LENGTH);
+    options.min_table_confidence = args.min_table_confidence.value_or(DEFAULT_MIN_TABLE_CONFIDENCE);
+    options.allow_brk = args.flag_brk;
+    options.propagate_constants = !args.flag_no_propagation;
+    options.auto_symbols = args.flag_auto_symbols;
+    options.print_input_symbols = args.flag_print_input_symbols;
+    options.stack_depth = args.flag_stack_depth;
+    options.irq_latency = args.flag_irq_latency;
+    options.xrefs = args.flag_xrefs;
+    options.syntax = args.syntax;
+
+    Analyzer const analyzer(std::move(segments), std::move(symbols), options, std::move(signatures));
+
+    if (args.opt_bank_file)
+    {
+        phase("banks");
 
-    std::vector<AddressBlock> const blocks = analyse_code_blocks(anal);
+        Log const log(std::cerr);
+        return disassemble_banks(args, analyzer, std::cerr, log) ? 0 : 3;
+    }
 
-    std::vector<Symbol> const new_symbols = build_symbols(anal, blocks, args.flag_auto_symbols);
-    std::vector<Symbol> const symbols = merge_sorted_vectors(anal.symbols, new_symbols);
+    if (args.opt_diff_input)
+    {
+        phase("diff");
 
-    std::vector<PrintItem> const print = gen_print_items(anal.main_block, blocks, symbols);
+        Log const log(std::cerr);
+        return diff_inputs(args, analyzer, std::cerr, log) ? 0 : 3;
+    }
 
-    const auto do_print = [&] (std::ostream& output)
+    if (args.opt_socket_file)
     {
-        print_symbols(anal.main_block, args.flag_print_input_symbols ? symbols : new_symbols, output);
-        print_items(anal.main_block, print, symbols, output);
-    };
+        phase("server");
+
+        Log const log(std::cerr);
+        return serve_analysis(args, analyzer, std::cerr, log) ? 0 : 3;
+    }
 
-    if (args.opt_output_file)
+    if (!args.opt_batch_file)
     {
-        std::string const file_name { *args.opt_output_file };
-        std::ofstream output(file_name);
+        Log const log(std::cerr);
+        return disassemble(args, analyzer, args.input, args.base_address, args.opt_output_file, std::cerr, log, phases) ? 0 : 3;
+    }
 
-        if (!output.is_open())
-        {
-            std::cerr << "Couldn't open file for write:" << std::endl;
-            std::cerr << "  " << file_name << std::endl;
-            std::cerr << std::endl;
+    // Batch mode
 
-            return 3;
-        }
+    phase("batch");
+
+    std::string const file_name { *args.opt_batch_file };
+    std::ifstream f(file_name);
+
+    if (!f.is_open())
+    {
+        std::cerr << "Couldn't open file for read:" << std::endl;
+        std::cerr << "  " << file_name << std::endl;
+        std::cerr << std::endl;
 
-        do_print(output);
+        return 3;
     }
-    else
+
+    std::vector<BatchJob> jobs;
+
+    try
     {
-        do_print(std::cout);
+        jobs = read_batch_manifest(f);
     }
+    catch (BatchError const& e)
+    {
+        std::cerr << "Failed to parse batch manifest \"" << file_name << "\":" << std::endl;
+        std::cerr << "  " << e.what() << std::endl;
+        std::cerr << std::endl;
+
+        return 3;
+    }
+
+    auto const run_job = [&] (BatchJob const& job, std::ostream& errors)
+    {
+        // analysis chatter from many jobs at once would be unreadable
+        return disassemble(args, analyzer, job.input, job.base_address, job.output_file, errors, Log {});
+    };
+
+    std::size_t const failures = run_batch(jobs, args.jobs, run_job, std::cerr);
+
+    if (analyzer.cache().hits() != 0)
+        std::cerr << "Reused analysis of " << analyzer.cache().hits() << " identical input(s)" << std::endl;
+
+    return (failures == 0) ? 0 : 1;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc >= 2 && std::strcmp(argv[1], "query") == 0)
+        return query_main(argc - 1, argv + 1);
+
+    Args const args = parse_args(argc, argv);
+
+    if (!args.alloc_stats)
+        return run(args, nullptr);
+
+    AllocPhases phases;
+
+    int const result = run(args, &phases);
+    phases.stop();
+
+    if (args.alloc_stats_json)
+        phases.print_json(std::cerr);
+    else
+        phases.print_table(std::cerr);
 
-    return 0;
+    return result;
 }
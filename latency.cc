@@ -0,0 +1,255 @@
+
+#include "latency.hh"
+
+namespace
+{
+
+constexpr int NEVER = -1;
+
+int chain(int a, int b)
+{
+    return (a == NEVER || b == NEVER) ? NEVER : a + b;
+}
+
+// Worst cases of every way a path starting at some point can go.
+struct Summary
+{
+    // ends the region (CLI, PLP or RTI)
+    int terminated = NEVER;
+    std::uint32_t end = 0;
+
+    // returns from the current routine with interrupts still disabled
+    int returned = NEVER;
+
+    // goes somewhere we can't follow
+    int lost = NEVER;
+
+    bool loops = false;
+
+    void merge(Summary const& other, int prefix)
+    {
+        int const terminated = chain(prefix, other.terminated);
+
+        if (terminated > this->terminated)
+        {
+            this->terminated = terminated;
+            this->end = other.end;
+        }
+
+        returned = std::max(returned, chain(prefix, other.returned));
+        lost = std::max(lost, chain(prefix, other.lost));
+        loops = loops || other.loops;
+    }
+};
+
+struct MaskedAnalysis
+{
+    enum : std::uint8_t
+    {
+        UNVISITED,
+        IN_PROGRESS,
+        DONE,
+    };
+
+    MaskedAnalysis(AnalConfig const& anal, FlowGraph const& graph)
+        : m_anal(anal), m_graph(graph),
+          m_summaries(graph.blocks.size()), m_states(graph.blocks.size(), UNVISITED) {}
+
+    Summary summarize(std::size_t index, std::uint32_t from)
+    {
+        FlowBlock const& block = m_graph.blocks[index];
+
+        Summary result {};
+
+        int cycles = 0;
+        bool stop = false;
+
+        for_each_flow_instr(m_anal, block, [&] (std::uint32_t addr, [[maybe_unused]] Instr const& instr, OpInfo const& info)
+        {
+            if (stop || addr < from)
+                return;
+
+            cycles += get_max_cycles(info);
+
+            switch (info.mnemonic)
+            {
+
+            case Mnem::CLI:
+            case Mnem::PLP:
+            case Mnem::RTI:
+                result.terminated = cycles;
+                result.end = addr;
+                stop = true;
+                break;
+
+            case Mnem::RTS:
+                result.returned = cycles;
+                stop = true;
+                break;
+
+            default:
+                break;
+
+            }
+        });
+
+        if (stop)
+            return result;
+
+        OpInfo const& info = *block.last_info;
+
+        if (info.flags & OpInfo::FLAG_CALL)
+        {
+            Summary const callee = get(block.jump);
+            Summary const next = get(block.next);
+
+            result.merge(callee, cycles);
+
+            // paths returning from the callee continue after the call
+            result.returned = NEVER;
+            result.merge(next, chain(cycles, callee.returned));
+
+            return result;
+        }
+
+        if ((info.flags & OpInfo::FLAG_JUMP) && info.addressing_mode != Am::ABS && info.addressing_mode != Am::REL)
+        {
+            // JMP (ind), BRK
+            result.lost = cycles;
+            return result;
+        }
+
+        if (!(info.flags & OpInfo::FLAG_END))
+            result.merge(get(block.next), cycles);
+
+        if (info.flags & OpInfo::FLAG_JUMP)
+            result.merge(get(block.jump), cycles);
+
+        return result;
+    }
+
+    // makes sure every block reachable from `root` has its summary
+    void visit(std::size_t root)
+    {
+        if (root == FlowGraph::NONE || m_states[root] == DONE)
+            return;
+
+        m_stack.push_back(root);
+
+        while (!m_stack.empty())
+        {
+            std::size_t const index = m_stack.back();
+
+            if (m_states[index] == UNVISITED)
+            {
+                m_states[index] = IN_PROGRESS;
+
+                FlowBlock const& block = m_graph.blocks[index];
+
+                for (std::size_t successor : { block.next, block.jump })
+                {
+                    if (successor != FlowGraph::NONE && m_states[successor] == UNVISITED)
+                        m_stack.push_back(successor);
+                }
+
+                continue;
+            }
+
+            m_stack.pop_back();
+
+            if (m_states[index] == DONE)
+                continue;
+
+            m_summaries[index] = summarize(index, m_graph.blocks[index].start);
+            m_states[index] = DONE;
+        }
+    }
+
+private:
+    Summary get(std::size_t index) const
+    {
+        Summary result {};
+
+        if (index == FlowGraph::NONE)
+        {
+            result.lost = 0;
+            return result;
+        }
+
+        if (m_states[index] != DONE)
+        {
+            // back edge
+            result.loops = true;
+            return result;
+        }
+
+        return m_summaries[index];
+    }
+
+    AnalConfig const& m_anal;
+    FlowGraph const& m_graph;
+
+    std::vector<Summary> m_summaries;
+    std::vector<std::uint8_t> m_states;
+    std::vector<std::size_t> m_stack;
+};
+
+}
+
+std::vector<MaskedRegion> analyse_masked_regions(AnalConfig const& anal, FlowGraph const& graph, std::vector<std::uint32_t> const& masked_entries)
+{
+    MaskedAnalysis analysis(anal, graph);
+
+    std::vector<std::pair<std::size_t, std::uint32_t>> starts;
+
+    for (std::uint32_t entry : masked_entries)
+    {
+        std::size_t const index = graph.find(entry);
+
+        if (index != FlowGraph::NONE)
+            starts.push_back({ index, entry });
+    }
+
+    for (std::size_t i = 0; i < graph.blocks.size(); ++i)
+    {
+        for_each_flow_instr(anal, graph.blocks[i], [&] (std::uint32_t addr, [[maybe_unused]] Instr const& instr, OpInfo const& info)
+        {
+            if (info.mnemonic == Mnem::SEI)
+                starts.push_back({ i, addr });
+        });
+    }
+
+    std::vector<MaskedRegion> result;
+
+    for (auto const& [index, address] : starts)
+    {
+        FlowBlock const& block = graph.blocks[index];
+
+        analysis.visit(block.next);
+        analysis.visit(block.jump);
+
+        Summary const summary = analysis.summarize(index, address);
+
+        MaskedRegion region {};
+
+        region.start = address;
+        region.max_cycles = std::max({ summary.terminated, summary.returned, summary.lost, 0 });
+        region.loops = summary.loops;
+        region.open = summary.returned != NEVER || summary.lost != NEVER;
+
+        if (summary.terminated != NEVER && summary.terminated >= std::max(summary.returned, summary.lost))
+            region.end = summary.end;
+
+        result.push_back(region);
+    }
+
+    std::sort(result.begin(), result.end(), [] (MaskedRegion const& l, MaskedRegion const& r)
+    {
+        if (l.max_cycles != r.max_cycles)
+            return l.max_cycles > r.max_cycles;
+
+        return l.start < r.start;
+    });
+
+    return result;
+}
@@ -0,0 +1,27 @@
+
+#pragma once
+
+#include "common.hh"
+#include "anal.hh"
+#include "flow.hh"
+
+#include <optional>
+
+struct MaskedRegion
+{
+    // address of the SEI, or of the interrupt handler entry
+    std::uint32_t start;
+
+    // address of the CLI/PLP/RTI ending the longest path, if it ends at one
+    std::optional<std::uint32_t> end;
+
+    unsigned max_cycles;
+
+    // a loop was cut short: cycles count a single iteration
+    bool loops : 1;
+
+    // some path leaves the region with interrupts still disabled (RTS, indirect jump, unknown code)
+    bool open : 1;
+};
+
+std::vector<MaskedRegion> analyse_masked_regions(AnalConfig const& anal, FlowGraph const& graph, std::vector<std::uint32_t> const& masked_entries);
@@ -0,0 +1,33 @@
+
+#pragma once
+
+#include <ostream>
+
+// Where analysis chatter goes. A Log without a stream discards everything.
+struct Log
+{
+    Log() = default;
+
+    explicit Log(std::ostream& stream)
+        : m_stream(&stream) {}
+
+    template<typename T>
+    Log const& operator << (T const& value) const
+    {
+        if (m_stream != nullptr)
+            *m_stream << value;
+
+        return *this;
+    }
+
+    Log const& operator << (std::ostream& (*manipulator)(std::ostream&)) const
+    {
+        if (m_stream != nullptr)
+            manipulator(*m_stream);
+
+        return *this;
+    }
+
+private:
+    std::ostream* m_stream = nullptr;
+};
@@ -0,0 +1,305 @@
+
+#include "pointers.hh"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// shorter runs of addresses are too common by chance
+constexpr std::size_t MIN_TABLE_ENTRIES = 3;
+
+// tables shorter than this are trusted less
+constexpr std::size_t TRUSTED_TABLE_ENTRIES = 6;
+
+static bool is_code_target(AnalConfig const& anal, std::uint32_t address)
+{
+    if (!anal.main_block.contains(address))
+        return false;
+
+    if (address_blocks_contain(anal.data_blocks, address) || address_blocks_contain(anal.fill_blocks, address))
+        return false;
+
+    for (Segment const& segment : anal.segments)
+    {
+        if (segment.contains(address))
+            return !!(segment.flags & Segment::FLAG_EXEC);
+    }
+
+    return false;
+}
+
+// Sets marks[i] to $FF where data[i] is between first_page and last_page: it could be the high byte of a code address
+static void mark_high_bytes(byte_type const* data, std::size_t size, byte_type first_page, byte_type last_page, std::vector<byte_type>& marks)
+{
+    marks.resize(size);
+
+    byte_type const span = last_page - first_page;
+    std::size_t i = 0;
+
+#ifdef __SSE2__
+    // (byte - first_page) <= span, unsigned: there is no unsigned compare but min is
+    __m128i const firsts = _mm_set1_epi8(static_cast<char>(first_page));
+    __m128i const spans = _mm_set1_epi8(static_cast<char>(span));
+
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i const offsets = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const*>(data + i)), firsts);
+        __m128i const in_range = _mm_cmpeq_epi8(_mm_min_epu8(offsets, spans), offsets);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(marks.data() + i), in_range);
+    }
+#endif
+
+    for (; i < size; ++i)
+        marks[i] = static_cast<byte_type>(data[i] - first_page) <= span ? 0xFF : 0x00;
+}
+
+// Rates the table of `entries` at `address` and adds the targets of those that decode as code. Entries that don't, at
+// either end, are most likely not part of the table.
+static void rate_table(AnalConfig const& anal, std::uint32_t address, char const* kind, bool read, std::vector<std::uint32_t> const& entries,
+    std::vector<CodePointCandidate>& result)
+{
+    // the best it could be rated: not worth decoding anything if not good enough
+    std::size_t best = read ? 100 : 50;
+
+    if (entries.size() < TRUSTED_TABLE_ENTRIES)
+        best = best * entries.size() / TRUSTED_TABLE_ENTRIES;
+
+    if (best < anal.min_table_confidence)
+        return;
+
+    // runs of one value are fills
+    if (std::all_of(entries.begin(), entries.end(), [&] (std::uint32_t entry) { return entry == entries.front(); }))
+        return;
+
+    std::uint32_t const block_end = anal.main_block.address + anal.main_block.data.size();
+
+    auto const decodes = [&] (std::uint32_t target)
+    {
+        return is_code_target(anal, target) && scan_code(anal, { target, block_end - target }).has_value();
+    };
+
+    std::vector<bool> direct(entries.size());
+    std::vector<bool> rts_trick(entries.size());
+
+    std::size_t direct_count = 0;
+    std::size_t rts_trick_count = 0;
+
+    for (std::size_t i = 0; i < entries.size(); ++i)
+    {
+        direct[i] = decodes(entries[i]);
+        rts_trick[i] = decodes(entries[i] + 1);
+
+        direct_count += direct[i];
+        rts_trick_count += rts_trick[i];
+    }
+
+    bool const is_rts_trick = rts_trick_count > direct_count;
+    std::vector<bool> const& valid = is_rts_trick ? rts_trick : direct;
+
+    std::size_t first = 0;
+    std::size_t last = entries.size();
+
+    // a table that is read from starts where it is read
+    if (!read)
+    {
+        while (first < last && !valid[first])
+            first++;
+    }
+
+    while (last > first && !valid[last - 1])
+        last--;
+
+    std::size_t const size = last - first;
+
+    if (size < MIN_TABLE_ENTRIES)
+        return;
+
+    std::size_t confidence = std::count(valid.begin() + first, valid.begin() + last, true) * 100 / size;
+
+    if (size < TRUSTED_TABLE_ENTRIES)
+        confidence = confidence * size / TRUSTED_TABLE_ENTRIES;
+
+    if (!read)
+        confidence /= 2;
+
+    anal.log << "Pointer table at " << hex_string<4>(address) << ": " << size << " " << kind << (is_rts_trick ? " (RTS trick)" : "")
+        << (read ? "" : " (never read)") << ", confidence " << confidence << "%" << std::endl;
+
+    for (std::size_t i = first; i < last; ++i)
+    {
+        if (valid[i])
+            result.push_back({ entries[i] + is_rts_trick, static_cast<std::uint8_t>(confidence) });
+    }
+}
+
+std::vector<CodePointCandidate> find_pointer_table_targets(AnalConfig const& anal, std::vector<AddressBlock> const& ranges,
+    std::vector<std::uint32_t> const& reads)
+{
+    std::vector<CodePointCandidate> result;
+
+    DataBlock const& block = anal.main_block;
+
+    if (block.data.empty())
+        return result;
+
+    // pages of code in the main block
+    std::uint32_t first_page = 0xFF;
+    std::uint32_t last_page = 0x00;
+
+    for (Segment const& segment : anal.segments)
+    {
+        if (!(segment.flags & Segment::FLAG_EXEC))
+            continue;
+
+        std::uint32_t const start = std::max<std::uint32_t>(segment.start, block.address);
+        std::uint32_t const end = std::min<std::uint32_t>({ segment.start + segment.size, block.address + static_cast<std::uint32_t>(block.data.size()), 0x10000 });
+
+        if (start >= end)
+            continue;
+
+        first_page = std::min(first_page, start >> 8);
+        last_page = std::max(last_page, (end - 1) >> 8);
+    }
+
+    if (first_page > last_page)
+        return result;
+
+    std::vector<byte_type> marks;
+    mark_high_bytes(block.data.data(), block.data.size(), first_page, last_page, marks);
+
+    auto const byte_at = [&] (std::uint32_t address) -> std::uint32_t
+    {
+        return block.data[address - block.address];
+    };
+
+    auto const marked = [&] (std::uint32_t address)
+    {
+        return marks[address - block.address] != 0;
+    };
+
+    std::vector<std::uint32_t> entries;
+
+    for (AddressBlock const& range : ranges)
+    {
+        std::uint32_t const end = range.start + range.size;
+
+        // words, at either alignment. A run of them may hold several tables, or begin with data: it is split where
+        // it is read from.
+
+        auto const rate_words = [&] (std::uint32_t table, std::uint32_t table_end)
+        {
+            std::uint32_t start = table;
+            bool is_read = false;
+
+            auto const rate = [&] (std::uint32_t piece_end)
+            {
+                entries.clear();
+
+                for (std::uint32_t address = start; address < piece_end; address += 2)
+                    entries.push_back(byte_at(address) | (byte_at(address + 1) << 8));
+
+                if (entries.size() >= MIN_TABLE_ENTRIES)
+                    rate_table(anal, start, "words", is_read, entries, result);
+            };
+
+            for (auto read = std::lower_bound(reads.begin(), reads.end(), table); read != reads.end() && *read < table_end; ++read)
+            {
+                // the high bytes are read from one past the start of the table
+                std::uint32_t const split = *read - (*read - table) % 2;
+
+                if (split != start)
+                {
+                    rate(split);
+                    start = split;
+                }
+
+                is_read = true;
+            }
+
+            rate(table_end);
+        };
+
+        for (std::uint32_t parity = 0; parity < 2; ++parity)
+        {
+            std::uint32_t table = range.start + parity;
+
+            for (std::uint32_t address = table; address + 1 < end; address += 2)
+            {
+                std::uint32_t const word = byte_at(address) | (byte_at(address + 1) << 8);
+
+                if (marked(address + 1) && is_code_target(anal, word))
+                    continue;
+
+                if (address - table >= MIN_TABLE_ENTRIES * 2)
+                    rate_words(table, address);
+
+                table = address + 2;
+            }
+
+            if (end - table >= MIN_TABLE_ENTRIES * 2)
+                rate_words(table, table + (end - table) / 2 * 2);
+        }
+
+        // split tables: a run of high bytes, with as many low bytes before or after it (or it is both halves)
+
+        auto const try_split = [&] (std::uint32_t lo, std::uint32_t hi, std::uint32_t count)
+        {
+            if (lo < range.start || lo + count > end || hi + count > end)
+                return;
+
+            entries.clear();
+
+            for (std::uint32_t i = 0; i < count; ++i)
+            {
+                std::uint32_t const target = byte_at(lo + i) | (byte_at(hi + i) << 8);
+
+                if (!is_code_target(anal, target))
+                    return;
+
+                entries.push_back(target);
+            }
+
+            rate_table(anal, lo, "split entries", in_sorted_vector(reads, lo) || in_sorted_vector(reads, hi), entries, result);
+        };
+
+        for (std::uint32_t address = range.start; address < end;)
+        {
+            if (!marked(address))
+            {
+                address++;
+                continue;
+            }
+
+            std::uint32_t const run_start = address;
+
+            while (address < end && marked(address))
+                address++;
+
+            std::uint32_t const count = address - run_start;
+
+            if (count < MIN_TABLE_ENTRIES)
+                continue;
+
+            if (run_start >= range.start + count)
+                try_split(run_start - count, run_start, count);
+
+            try_split(address, run_start, count);
+
+            if (count % 2 == 0 && count / 2 >= MIN_TABLE_ENTRIES)
+                try_split(run_start, run_start + count / 2, count / 2);
+        }
+    }
+
+    std::sort(result.begin(), result.end(), [] (CodePointCandidate const& l, CodePointCandidate const& r)
+    {
+        return l.address < r.address || (l.address == r.address && l.confidence > r.confidence);
+    });
+
+    result.erase(std::unique(result.begin(), result.end(), [] (CodePointCandidate const& l, CodePointCandidate const& r)
+    {
+        return l.address == r.address;
+    }), result.end());
+
+    return result;
+}
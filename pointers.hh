@@ -0,0 +1,22 @@
+
+#pragma once
+
+#include "common.hh"
+#include "anal.hh"
+
+// Where a pointer table says code may start, and how sure it is (percent)
+struct CodePointCandidate
+{
+    std::uint32_t address;
+    std::uint8_t confidence;
+};
+
+constexpr std::uint8_t DEFAULT_MIN_TABLE_CONFIDENCE = 75;
+
+// Looks through `ranges` (sorted) for tables of addresses of executable code in the main block: little-endian words,
+// or tables of low bytes next to tables of high bytes. Entries of tables used with the RTS trick point one byte before
+// their targets. Tables are rated on how many of their targets decode as code, and trusted half as much if no address
+// of `reads` (sorted operands of the code found so far) starts them. Tables that can't be rated at least
+// anal.min_table_confidence are left out. Candidates are sorted by address.
+std::vector<CodePointCandidate> find_pointer_table_targets(AnalConfig const& anal, std::vector<AddressBlock> const& ranges,
+    std::vector<std::uint32_t> const& reads);
@@ -1,7 +1,118 @@
 
 #include "print.hh"
 
-std::string instr_to_string(Instr const& instr, std::vector<Symbol> const& symbols)
+#include <cinttypes>
+#include <cstdio>
+#include <iomanip>
+#include <optional>
+
+static std::string exec_name(std::vector<Symbol> const& symbols, std::uint32_t address)
+{
+    auto const syms = symbols_at(symbols, address);
+
+    for (auto it = syms.first; it != syms.second; ++it)
+    {
+        if (it->flags & Symbol::FLAG_EXEC)
+            return it->name;
+    }
+
+    return std::string("$") + hex_string<4>(address);
+}
+
+std::string locate_name(std::vector<Symbol> const& symbols, std::uint32_t address)
+{
+    auto it = std::upper_bound(symbols.begin(), symbols.end(), address, Symbol::Compare {});
+
+    while (it != symbols.begin())
+    {
+        --it;
+
+        if (!(it->flags & Symbol::FLAG_EXEC))
+            continue;
+
+        if (it->value == address)
+            return it->name;
+
+        return it->name + "+$" + hex_string<2>(address - it->value);
+    }
+
+    return std::string("$") + hex_string<4>(address);
+}
+
+Symbol const* find_operand_symbol(OpInfo const& info, Instr const& instr, std::vector<Symbol> const& symbols)
+{
+    const auto syms = symbols_at(symbols, instr.operand);
+
+    for (auto it = syms.first; it != syms.second; ++it)
+    {
+        if (info.flags & OpInfo::FLAG_JUMP)
+        {
+            if (it->flags & Symbol::FLAG_EXEC)
+                return &*it;
+        }
+        else if (info.flags & OpInfo::FLAG_WRITE)
+        {
+            if (it->flags & Symbol::FLAG_WRITE)
+                return &*it;
+        }
+        else
+        {
+            if (it->flags & Symbol::FLAG_READ)
+                return &*it;
+        }
+    }
+
+    return nullptr;
+}
+
+std::optional<AsmSyntax> parse_asm_syntax(std::string_view name)
+{
+    if (name == "julian")
+        return AsmSyntax::Julian;
+
+    if (name == "ca65")
+        return AsmSyntax::Ca65;
+
+    if (name == "asm6")
+        return AsmSyntax::Asm6;
+
+    if (name == "nesasm")
+        return AsmSyntax::Nesasm;
+
+    if (name == "acme")
+        return AsmSyntax::Acme;
+
+    return std::nullopt;
+}
+
+template<unsigned DigitCount>
+static void append_hex(std::string& out, unsigned value)
+{
+    static char const digits[] = "0123456789ABCDEF";
+
+    for (unsigned i = DigitCount; i != 0; --i)
+        out.push_back(digits[(value >> ((i-1)*4)) & 0xF]);
+}
+
+// "A9 00", padded with spaces to at least `min_length`
+static void append_hex_bytes(std::string& out, byte_type const* bytes, std::size_t count, std::size_t min_length)
+{
+    std::size_t const start = out.size();
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (i != 0)
+            out.push_back(' ');
+
+        append_hex<2>(out, bytes[i]);
+    }
+
+    if (out.size() - start < min_length)
+        out.append(min_length - (out.size() - start), ' ');
+}
+
+template<typename Syntax>
+static void append_instr(std::string& out, Instr const& instr, std::vector<Symbol> const& symbols)
 {
     // Step 1. find opcode info
 
@@ -9,79 +120,72 @@ std::string instr_to_string(Instr const& instr, std::vector<Symbol> const& symbo
 
     if (info == nullptr)
     {
-        using namespace std::string_literals;
-        return ".db $"s + hex_string<2>(instr.opcode);
+        out += Syntax::byte_directive;
+        out += " $";
+        append_hex<2>(out, instr.opcode);
+
+        return;
     }
 
-    // Step 2. get operand string
+    Am const am = info->addressing_mode;
+    OperandTemplate const& operand = Syntax::operands[static_cast<std::size_t>(am)];
 
-    std::string operand_str = {};
+    // Step 2. mnemonic and decoration
 
-    switch (info->addressing_mode)
+    for (char const* chr = info->name; *chr != '\0'; ++chr)
+        out.push_back((Syntax::upper_mnemonics && *chr >= 'a' && *chr <= 'z') ? *chr - 'a' + 'A' : *chr);
+
+    bool const absolute = (am == Am::ABS || am == Am::ABX || am == Am::ABY) && instr.operand < 0x100;
+
+    if constexpr (Syntax::force_absolute.mnemonic_suffix[0] != '\0')
     {
+        if (absolute)
+            out += Syntax::force_absolute.mnemonic_suffix;
+    }
 
-    case Am::ZRP:
-    case Am::ZRX:
-    case Am::ZRY:
-    case Am::ABS:
-    case Am::ABX:
-    case Am::ABY:
-    case Am::INX:
-    case Am::INY:
-    case Am::IAB:
-    case Am::REL:
+    out += operand.prefix;
+
+    if constexpr (Syntax::force_absolute.operand_prefix[0] != '\0')
     {
-        const auto syms = symbols_at(symbols, instr.operand);
+        if (absolute)
+            out += Syntax::force_absolute.operand_prefix;
+    }
 
-        for (auto it = syms.first; it != syms.second; ++it)
-        {
-            if (info->flags & OpInfo::FLAG_JUMP)
-            {
-                if (it->flags & Symbol::FLAG_EXEC)
-                {
-                    operand_str = it->name;
-                    break;
-                }
-            }
-            else if (info->flags & OpInfo::FLAG_WRITE)
-            {
-                if (it->flags & Symbol::FLAG_WRITE)
-                {
-                    operand_str = it->name;
-                    break;
-                }
-            }
-            else
-            {
-                if (it->flags & Symbol::FLAG_READ)
-                {
-                    operand_str = it->name;
-                    break;
-                }
-            }
-        }
+    // Step 3. operand
+
+    Symbol const* symbol = nullptr;
+
+    switch (am)
+    {
 
+    case Am::IMP:
+    case Am::ACC:
+    case Am::IMM:
         break;
-    }
 
     default:
+        symbol = find_operand_symbol(*info, instr, symbols);
         break;
 
     }
 
-    if (operand_str.empty())
+    if (symbol != nullptr)
     {
-        switch (get_addressing_mode_operand_size(info->addressing_mode))
+        out += symbol->name;
+    }
+    else
+    {
+        switch (get_addressing_mode_operand_size(am))
         {
 
         case 1:
-            operand_str.push_back('$');
-            operand_str.append(hex_string<2>(instr.operand));
+            out.push_back('$');
+            append_hex<2>(out, instr.operand);
             break;
 
         case 2:
-            operand_str.push_back('$');
-            operand_str.append(hex_string<4>(instr.operand));
+            out.push_back('$');
+            append_hex<4>(out, instr.operand);
             break;
 
         default:
@@ -90,271 +194,489 @@ std::string instr_to_string(Instr const& instr, std::vector<Symbol> const& symbo
         }
     }
 
-    // Step 3. print operand and decoration
+    out += operand.suffix;
+}
 
-    std::string result(info->name);
+std::string instr_to_string(Instr const& instr, std::vector<Symbol> const& symbols)
+{
+    std::string result;
+    append_instr<syntax::Julian>(result, instr, symbols);
 
-    switch (info->addressing_mode)
-    {
+    return result;
+}
 
-    case Am::IMP:
-        break;
+std::vector<PrintItem> gen_print_items(AddressBlock const& range, std::vector<AddressBlock> const& code_blocks, std::vector<Symbol> const& symbols)
+{
+    std::vector<PrintItem> result;
 
-    case Am::ACC:
+    for_each_print_item(range, code_blocks, symbols, [&] (auto const& item)
     {
-        result += " A";
+        using T = std::decay_t<decltype(item)>;
 
-        break;
-    }
+        if constexpr (std::is_same_v<T, Symbol>)
+            result.emplace_back(PrintName(item.name, item.value));
+        else
+            result.emplace_back(item);
+    });
 
-    case Am::IMM:
-    {
-        result += " #";
-        result += operand_str;
+    return result;
+}
 
-        break;
-    }
+// executions and share of total cycles
+static void print_hotness(EmuProfile const* profile, std::optional<std::uint32_t> address, std::ostream& output)
+{
+    if (profile == nullptr)
+        return;
 
-    case Am::ZRP:
+    if (!address || *address >= profile->executions.size() || profile->executions[*address] == 0)
     {
-        result += " ";
-        result += operand_str;
-
-        break;
+        output << std::setw(18) << "" << ' ';
+        return;
     }
 
-    case Am::ZRX:
-    {
-        result += " ";
-        result += operand_str;
-        result += ", X";
+    double const share = 100.0 * profile->cycles[*address] / std::max<std::uint64_t>(profile->total_cycles, 1);
 
-        break;
-    }
+    // formatted apart, to leave the stream's flags alone
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%10" PRIu64 " %6.1f%% ", profile->executions[*address], share);
 
-    case Am::ZRY:
-    {
-        result += " ";
-        result += operand_str;
-        result += ", Y";
+    output << buffer;
+}
 
-        break;
-    }
+// "referenced from" comment lines under a label
+template<typename Syntax>
+static void print_xrefs(XrefIndex const* xrefs, std::uint32_t address, std::vector<Symbol> const& symbols, std::ostream& output)
+{
+    constexpr std::size_t XREFS_PER_LINE = 4;
 
-    case Am::ABS:
-    {
-        result += " ";
-        result += operand_str;
+    if (xrefs == nullptr)
+        return;
 
-        break;
-    }
+    XrefIndex::Range const refs = xrefs->to(address);
 
-    case Am::ABX:
+    for (std::size_t i = 0; i < refs.size(); ++i)
     {
-        result += " ";
-        result += operand_str;
-        result += ", X";
+        Xref const& xref = refs.first[i];
 
-        break;
-    }
+        if (i % XREFS_PER_LINE == 0)
+            output << (Syntax::line_comments ? "    ; referenced from " : "    /* referenced from ");
+        else
+            output << ", ";
 
-    case Am::ABY:
-    {
-        result += " ";
-        result += operand_str;
-        result += ", Y";
+        output << locate_name(symbols, xref.source) << " (" << xref_kind_name(xref.kind) << ")";
 
-        break;
+        if (i % XREFS_PER_LINE == XREFS_PER_LINE - 1 || i + 1 == refs.size())
+            output << (Syntax::line_comments ? "" : " */") << std::endl;
     }
+}
 
-    case Am::IAB:
-    {
-        result += " (";
-        result += operand_str;
-        result += ")";
+// `for_each_item` calls its argument with each item of the listing: PrintCode, PrintData, PrintName or Symbol (label)
+template<typename Syntax, typename ForEachItem>
+static void print_items_as(DataBlock const& main_block, ForEachItem const& for_each_item, std::vector<Symbol> const& symbols,
+    std::ostream& output, PrintExtras const& extras)
+{
+    // where comments go after instructions and data, with line comments
+    constexpr std::size_t COMMENT_COLUMN = 32;
 
-        break;
-    }
+    EmuProfile const* const profile = extras.profile;
 
-    case Am::INX:
+    auto const mark = [&] (std::uint32_t address)
     {
-        result += " (";
-        result += operand_str;
-        result += ", X)";
+        if (extras.line_marks != nullptr)
+            extras.line_marks->push_back({ address, static_cast<std::uint64_t>(output.tellp()) });
+    };
 
-        break;
-    }
+    // references are listed once per address, under its last label
+    std::optional<std::uint32_t> labelled;
 
-    case Am::INY:
+    auto const end_labels = [&] ()
     {
-        result += " (";
-        result += operand_str;
-        result += "), Y";
+        if (labelled)
+            print_xrefs<Syntax>(extras.xrefs, *labelled, symbols, output);
 
-        break;
-    }
+        labelled.reset();
+    };
 
-    case Am::REL:
+    auto const print_label = [&] (std::string const& name, std::uint32_t address)
     {
-        result += " ";
-        result += operand_str;
+        if (labelled != address)
+            end_labels();
 
-        break;
-    }
+        mark(address);
 
-    }
+        output << name << Syntax::label_suffix << std::endl;
 
-    return result;
-}
+        labelled = address;
+    };
 
-std::vector<PrintItem> gen_print_items(AddressBlock const& range, std::vector<AddressBlock> const& code_blocks, std::vector<Symbol> const& symbols)
-{
-    std::vector<AddressBlock> const& data_blocks = inverted_blocks(range, code_blocks);
+    // reused for every line
+    std::string line;
 
-    enum struct Kind
+    for_each_item([&] (auto const& item)
     {
-        Code, Data, Name,
-    };
+        using T = std::decay_t<decltype(item)>;
+
+        if constexpr (std::is_same_v<T, PrintName>)
+        {
+            print_label(item, item.address);
+        }
+        else if constexpr (std::is_same_v<T, Symbol>)
+        {
+            print_label(item.name, item.value);
+        }
+        else
+        {
+            end_labels();
+        }
 
-    struct Item { Kind kind; std::string name; };
+        if constexpr (std::is_same_v<T, PrintCode>)
+        {
+            for_each_instr(main_block.bytes(item), item, [&] (std::uint32_t addr, Instr const& instr)
+            {
+                byte_type const* const bytes = main_block.data.data() + (addr - main_block.address);
+                std::size_t const size = get_instr_size(instr);
 
-    std::vector<std::pair<std::uint32_t, Item>> map;
+                mark(addr);
 
-    for (AddressBlock const& code_block : code_blocks)
-        map.emplace_back(code_block.start, Item { Kind::Code, {} });
+                if constexpr (Syntax::line_comments)
+                {
+                    line.assign("    ");
+                    append_instr<Syntax>(line, instr, symbols);
+                    line.append(line.size() < COMMENT_COLUMN ? COMMENT_COLUMN - line.size() : 1, ' ');
+                    line.append("; ");
+
+                    output << line;
+                    print_hotness(profile, addr, output);
+
+                    line.clear();
+                    append_hex<4>(line, addr);
+                    line.push_back(' ');
+                    append_hex_bytes(line, bytes, size, 0);
+                }
+                else
+                {
+                    output << "    /* ";
+                    print_hotness(profile, addr, output);
+
+                    line.clear();
+                    append_hex<4>(line, addr);
+                    line.push_back(' ');
+                    append_hex_bytes(line, bytes, size, 8);
+                    line.append(" */ ");
+                    append_instr<Syntax>(line, instr, symbols);
+                }
 
-    for (AddressBlock const& data_block : data_blocks)
-        map.emplace_back(data_block.start, Item { Kind::Data, {} });
+                output << line << std::endl;
+            });
 
-    for (Symbol const& symbol : symbols)
-        if (range.contains(symbol.value) && (symbol.flags & (Symbol::FLAG_READ | Symbol::FLAG_EXEC)))
-            map.emplace_back(symbol.value, Item { Kind::Name, symbol.name });
+            output << std::endl;
+        }
 
-    std::sort(map.begin(), map.end(), [&] (auto& left, auto& right) -> bool
-    {
-        if (left.first == right.first)
+        if constexpr (std::is_same_v<T, PrintData>)
         {
-            if (left.second.kind == Kind::Name)
-                return true;
+            constexpr std::size_t BYTES_PER_LINE = 8;
+
+            std::uint32_t const item_end = item.start + item.size;
+
+            // fills, from the first one not ending before the item
+            AddressBlock const* fill = nullptr;
+            AddressBlock const* fills_end = nullptr;
+
+            if constexpr (Syntax::fill_directive != nullptr)
+            {
+                if (extras.fills != nullptr)
+                {
+                    fills_end = extras.fills->data() + extras.fills->size();
+                    fill = std::partition_point(extras.fills->data(), fills_end, [&] (AddressBlock const& block)
+                    {
+                        return block.start + block.size <= item.start;
+                    });
+                }
+            }
+
+            auto const begin_line = [&] (std::uint32_t addr)
+            {
+                mark(addr);
+
+                line.clear();
+
+                if constexpr (!Syntax::line_comments)
+                {
+                    output << "    /* ";
+                    print_hotness(profile, std::nullopt, output);
+
+                    append_hex<4>(line, addr);
+                    line.append(" ...      */ ");
+                }
+                else
+                {
+                    line.append("    ");
+                }
+            };
+
+            auto const end_line = [&] (std::uint32_t addr)
+            {
+                if constexpr (Syntax::line_comments)
+                {
+                    line.append(line.size() < COMMENT_COLUMN ? COMMENT_COLUMN - line.size() : 1, ' ');
+                    line.append("; ");
+                    append_hex<4>(line, addr);
+                }
 
-            return false;
+                output << line << std::endl;
+            };
+
+            for (std::uint32_t addr = item.start; addr < item_end;)
+            {
+                if (fill != fills_end && fill->start <= addr)
+                {
+                    std::uint32_t const end = std::min(fill->start + fill->size, item_end);
+
+                    begin_line(addr);
+
+                    line.append(Syntax::fill_directive);
+                    line.push_back(' ');
+                    line.append(std::to_string(end - addr));
+                    line.append(", $");
+                    append_hex<2>(line, main_block.data[addr - main_block.address]);
+
+                    end_line(addr);
+
+                    addr = end;
+                    ++fill;
+
+                    continue;
+                }
+
+                std::uint32_t end = std::min<std::uint32_t>(addr + BYTES_PER_LINE, item_end);
+
+                if (fill != fills_end)
+                    end = std::min(end, fill->start);
+
+                begin_line(addr);
+
+                line.append(Syntax::byte_directive);
+                line.push_back(' ');
+
+                for (std::uint32_t i = addr; i < end; ++i)
+                {
+                    if (i != addr)
+                        line.append(", ");
+
+                    line.push_back('$');
+                    append_hex<2>(line, main_block.data[i - main_block.address]);
+                }
+
+                end_line(addr);
+
+                addr = end;
+            }
+
+            output << std::endl;
         }
+    });
 
-        return left.first < right.first;
+    end_labels();
+}
+
+void print_items(DataBlock const& main_block, std::vector<PrintItem> const& items, std::vector<Symbol> const& symbols, std::ostream& output,
+    PrintExtras const& extras)
+{
+    auto const for_each_item = [&] (auto&& func)
+    {
+        for (PrintItem const& item : items)
+            std::visit(func, item);
+    };
+
+    with_syntax(extras.syntax, [&] (auto syntax)
+    {
+        print_items_as<decltype(syntax)>(main_block, for_each_item, symbols, output, extras);
     });
+}
 
-    std::vector<PrintItem> result;
+void print_listing(DataBlock const& main_block, std::vector<AddressBlock> const& code_blocks, std::vector<Symbol> const& symbols,
+    std::ostream& output, PrintExtras const& extras)
+{
+    AddressBlock const range { main_block.address, static_cast<std::uint32_t>(main_block.data.size()) };
 
-    Kind prev_kind = Kind::Name;
+    auto const for_each_item = [&] (auto&& func)
+    {
+        for_each_print_item(range, code_blocks, symbols, func);
+    };
 
-    for (std::size_t i = 0; i < map.size(); ++i)
+    with_syntax(extras.syntax, [&] (auto syntax)
     {
-        std::uint32_t const addr = map[i].first;
-        std::uint32_t const size = [&] ()
-        {
-            if (i+1 == map.size())
-                return range.start + range.size - addr;
+        print_items_as<decltype(syntax)>(main_block, for_each_item, symbols, output, extras);
+    });
+}
 
-            return map[i+1].first - addr;
-        } ();
+void print_as_line_comments(std::string_view text, std::ostream& output)
+{
+    while (!text.empty())
+    {
+        std::size_t const end = text.find('\n');
+        std::string_view line = text.substr(0, end);
 
-        Kind kind = map[i].second.kind;
+        text = (end == std::string_view::npos) ? std::string_view {} : text.substr(end + 1);
 
-        if (kind == Kind::Name)
+        if (line.empty())
         {
-            result.emplace_back(PrintName(map[i].second.name));
-            kind = prev_kind;
+            output << std::endl;
+            continue;
         }
 
-        if (size != 0)
-        {
-            switch (kind)
-            {
+        // "/* title", " *   item", " */", or a whole "/* comment */"
 
-            case Kind::Code:
-                result.emplace_back(PrintCode({ addr, size }));
-                break;
+        if (line.size() >= 2 && line.substr(line.size() - 2) == "*/")
+            line.remove_suffix(2);
 
-            case Kind::Data:
-                result.emplace_back(PrintData({ addr, size }));
-                break;
+        if (line.substr(0, 2) == "/*" || line.substr(0, 2) == " *")
+            line.remove_prefix(2);
 
-            default:
-                break;
+        while (!line.empty() && line.back() == ' ')
+            line.remove_suffix(1);
 
-            }
-        }
+        if (line.empty())
+            continue;
 
-        prev_kind = kind;
+        output << (line.front() == ' ' ? ";" : "; ") << line << std::endl;
     }
+}
 
-    return result;
+void print_symbols(AddressBlock const& main_block, std::vector<Symbol> const& symbols, std::ostream& output)
+{
+    for (Symbol const& symbol : symbols)
+    {
+        if (main_block.contains(symbol.value))
+            continue;
+
+        output << "    " << symbol.name << " = $" << hex_string<4>(symbol.value) << std::endl;
+    }
+
+    output << std::endl;
 }
 
-void print_items(DataBlock const& main_block, std::vector<PrintItem> const& items, std::vector<Symbol> const& symbols, std::ostream& output)
+void print_stack_depths(std::vector<StackDepth> const& depths, std::vector<Symbol> const& symbols, std::ostream& output)
 {
-    for (PrintItem const& item : items)
+    output << "/* Maximum stack depth" << std::endl;
+
+    for (StackDepth const& depth : depths)
     {
-        std::visit([&] (auto& item)
-        {
-            using T = std::decay_t<decltype(item)>;
+        output << " *   " << depth.name << " ($" << hex_string<4>(depth.address) << "): " << depth.max_depth << " bytes";
 
-            if constexpr (std::is_same_v<T, PrintCode>)
-            {
-                for_each_instr(main_block.bytes(item), item, [&] (std::uint32_t addr, Instr const& instr)
-                {
-                    auto const first = main_block.data.begin() + (addr - main_block.address);
-                    auto const last  = main_block.data.begin() + (addr + get_instr_size(instr) - main_block.address);
+        if (depth.recursive)
+            output << " (recursive, lower bound)";
 
-                    output << "    /* " << hex_string<4>(addr) << " " << hex_string<8>(first, last) << " */ " << instr_to_string(instr, symbols) << std::endl;
-                });
+        if (depth.unbounded)
+            output << " (unbounded push loop)";
 
-                output << std::endl;
-            }
+        output << std::endl;
+        output << " *     ";
 
-            if constexpr (std::is_same_v<T, PrintData>)
-            {
-                constexpr std::size_t BYTES_PER_LINE = 8;
+        for (std::size_t i = 0; i < depth.path.size(); ++i)
+        {
+            if (i != 0)
+                output << " -> ";
 
-                for (std::size_t i = 0; i < item.size; i += BYTES_PER_LINE)
-                {
-                    std::size_t count = std::min(BYTES_PER_LINE, item.size - i);
+            output << exec_name(symbols, depth.path[i]);
+        }
 
-                    output << "    /* " << hex_string<4>(item.start + i) << " ...      */ .db ";
+        output << std::endl;
+    }
 
-                    for (std::size_t j = 0; j < count; ++j)
-                    {
-                        byte_type const byte = main_block.data[item.start - main_block.address + i + j];
+    output << " */" << std::endl;
+    output << std::endl;
+}
 
-                        if (j != 0)
-                            output << ", ";
+void print_masked_regions(std::vector<MaskedRegion> const& regions, std::vector<Symbol> const& symbols, std::ostream& output)
+{
+    output << "/* Longest regions with interrupts disabled" << std::endl;
 
-                        output << "$" << hex_string<2>(byte);
-                    }
+    for (MaskedRegion const& region : regions)
+    {
+        output << " *   " << region.max_cycles << " cycles: " << hex_string<4>(region.start) << " " << locate_name(symbols, region.start);
 
-                    output << std::endl;
-                }
+        if (region.end)
+            output << " to " << hex_string<4>(*region.end) << " " << locate_name(symbols, *region.end);
+        else
+            output << " (worst path leaves the region)";
 
-                output << std::endl;
-            }
+        if (region.loops)
+            output << " (loops counted once)";
 
-            if constexpr (std::is_same_v<T, PrintName>)
-            {
-                output << item << ":" << std::endl;
-            }
-        }, item);
+        if (region.open)
+            output << " (may return with interrupts disabled)";
+
+        output << std::endl;
     }
+
+    output << " */" << std::endl;
+    output << std::endl;
 }
 
-void print_symbols(AddressBlock const& main_block, std::vector<Symbol> const& symbols, std::ostream& output)
+void print_profile_summary(EmuProfile const& profile, std::vector<Symbol> const& symbols, std::size_t count, std::ostream& output)
 {
+    struct Routine
+    {
+        std::uint32_t address;
+        std::uint64_t cycles;
+        std::uint64_t instructions;
+    };
+
+    std::vector<Symbol const*> entries;
+
     for (Symbol const& symbol : symbols)
     {
-        if (main_block.contains(symbol.value))
+        if (symbol.flags & Symbol::FLAG_EXEC)
+            entries.push_back(&symbol);
+    }
+
+    std::vector<Routine> routines;
+
+    // symbols are sorted: attribute each address to the closest code symbol before it
+
+    std::size_t entry = 0;
+
+    for (std::uint32_t addr = 0; addr < profile.executions.size(); ++addr)
+    {
+        while (entry < entries.size() && entries[entry]->value <= addr)
+            entry++;
+
+        if (profile.executions[addr] == 0)
             continue;
 
-        output << "    " << symbol.name << " = $" << hex_string<4>(symbol.value) << std::endl;
+        std::uint32_t const routine = (entry == 0) ? 0 : entries[entry-1]->value;
+
+        if (routines.empty() || routines.back().address != routine)
+            routines.push_back({ routine, 0, 0 });
+
+        routines.back().cycles += profile.cycles[addr];
+        routines.back().instructions += profile.executions[addr];
+    }
+
+    std::sort(routines.begin(), routines.end(), [] (Routine const& l, Routine const& r)
+    {
+        return l.cycles > r.cycles;
+    });
+
+    if (routines.size() > count)
+        routines.resize(count);
+
+    output << "/* Hottest routines (" << profile.total_cycles << " cycles)" << std::endl;
+
+    for (Routine const& routine : routines)
+    {
+        double const share = 100.0 * routine.cycles / std::max<std::uint64_t>(profile.total_cycles, 1);
+
+        char percent[16];
+        std::snprintf(percent, sizeof(percent), "%5.1f%% ", share);
+
+        output << " *   " << percent
+            << std::setw(12) << routine.cycles << " cycles "
+            << std::setw(10) << routine.instructions << " instrs  "
+            << exec_name(symbols, routine.address) << std::endl;
     }
 
+    output << " */" << std::endl;
     output << std::endl;
 }
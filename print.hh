@@ -4,12 +4,23 @@
 #include "common.hh"
 #include "disasm.hh"
 #include "symbol.hh"
+#include "stack.hh"
+#include "latency.hh"
+#include "emu.hh"
+#include "xref.hh"
+#include "syntax.hh"
 
 #include <variant>
 #include <iostream>
 
+// symbol naming the address operand of an instruction, nullptr if none
+Symbol const* find_operand_symbol(OpInfo const& info, Instr const& instr, std::vector<Symbol> const& symbols);
+
 std::string instr_to_string(Instr const& instr, std::vector<Symbol> const& symbols);
 
+// name of the closest code symbol at or before `address`, with offset ("NAME+$XX")
+std::string locate_name(std::vector<Symbol> const& symbols, std::uint32_t address);
+
 struct PrintCode : public AddressBlock
 {
     PrintCode(AddressBlock&& a)
@@ -24,15 +35,115 @@ struct PrintData : public AddressBlock
 
 struct PrintName : public std::string
 {
-    PrintName(std::string&& a)
-        : std::string(std::move(a)) {}
+    PrintName(std::string&& a, std::uint32_t address)
+        : std::string(std::move(a)), address(address) {}
 
-    PrintName(std::string const& a)
-        : std::string(a) {}
+    PrintName(std::string const& a, std::uint32_t address)
+        : std::string(a), address(address) {}
+
+    std::uint32_t address;
 };
 
 using PrintItem = std::variant<PrintCode, PrintData, PrintName>;
 
+// Calls func with each item of the listing of `range`, in order, as it goes: PrintCode and PrintData (blocks split at
+// labels), and Symbol const& for labels. `code_blocks` (sorted), the data between them and the symbols are merged
+// without building anything.
+template<typename Func>
+void for_each_print_item(AddressBlock const& range, std::vector<AddressBlock> const& code_blocks, std::vector<Symbol> const& symbols, Func&& func)
+{
+    std::uint32_t const range_end = range.start + range.size;
+
+    auto symbol = std::lower_bound(symbols.begin(), symbols.end(), range.start, Symbol::Compare {});
+    auto const symbols_end = std::lower_bound(symbol, symbols.end(), range_end, Symbol::Compare {});
+
+    auto const next_label = [&] ()
+    {
+        while (symbol != symbols_end && !(symbol->flags & (Symbol::FLAG_READ | Symbol::FLAG_EXEC)))
+            ++symbol;
+    };
+
+    std::size_t code_index = 0;
+    std::uint32_t address = range.start;
+
+    next_label();
+
+    while (address < range_end)
+    {
+        bool const code = code_index < code_blocks.size() && code_blocks[code_index].start <= address;
+        std::uint32_t block_end = range_end;
+
+        if (code)
+        {
+            block_end = std::min(code_blocks[code_index].start + code_blocks[code_index].size, range_end);
+            code_index++;
+
+            if (block_end <= address)
+                continue;
+        }
+        else if (code_index < code_blocks.size())
+        {
+            block_end = std::min(code_blocks[code_index].start, range_end);
+        }
+
+        auto const piece = [&] (std::uint32_t end)
+        {
+            if (end == address)
+                return;
+
+            if (code)
+                func(PrintCode({ address, end - address }));
+            else
+                func(PrintData({ address, end - address }));
+
+            address = end;
+        };
+
+        for (; symbol != symbols_end && symbol->value < block_end; ++symbol, next_label())
+        {
+            piece(symbol->value);
+            func(*symbol);
+        }
+
+        piece(block_end);
+    }
+}
+
 std::vector<PrintItem> gen_print_items(AddressBlock const& range, std::vector<AddressBlock> const& code_blocks, std::vector<Symbol> const& symbols);
-void print_items(DataBlock const& main_block, std::vector<PrintItem> const& items, std::vector<Symbol> const& symbols, std::ostream& output);
+
+// where the listing of an address starts in the output
+struct LineMark
+{
+    std::uint32_t address;
+    std::uint64_t offset;
+};
+
+// Optional annotations for print_items
+struct PrintExtras
+{
+    EmuProfile const* profile = nullptr;
+    XrefIndex const* xrefs = nullptr;
+
+    // runs of a repeated byte (sorted), data in them is listed as fills
+    std::vector<AddressBlock> const* fills = nullptr;
+
+    // filled with the output position (tellp) of each label, instruction and data line
+    std::vector<LineMark>* line_marks = nullptr;
+
+    AsmSyntax syntax = AsmSyntax::Julian;
+};
+
+void print_items(DataBlock const& main_block, std::vector<PrintItem> const& items, std::vector<Symbol> const& symbols, std::ostream& output,
+    PrintExtras const& extras = {});
+
+// Same as print_items of gen_print_items for the whole block, but streaming
+void print_listing(DataBlock const& main_block, std::vector<AddressBlock> const& code_blocks, std::vector<Symbol> const& symbols,
+    std::ostream& output, PrintExtras const& extras = {});
+
+// rewrites the /* */ comments the reports are made of for syntaxes with line comments only
+void print_as_line_comments(std::string_view text, std::ostream& output);
+
 void print_symbols(AddressBlock const& main_block, std::vector<Symbol> const& symbols, std::ostream& output);
+void print_stack_depths(std::vector<StackDepth> const& depths, std::vector<Symbol> const& symbols, std::ostream& output);
+void print_masked_regions(std::vector<MaskedRegion> const& regions, std::vector<Symbol> const& symbols, std::ostream& output);
+void print_profile_summary(EmuProfile const& profile, std::vector<Symbol> const& symbols, std::size_t count, std::ostream& output);
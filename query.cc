@@ -0,0 +1,127 @@
+
+#include "query.hh"
+
+#include "index.hh"
+
+#include <fstream>
+#include <iostream>
+
+static std::string describe(IndexView const& index, std::uint32_t address)
+{
+    auto const symbols = index.section<IndexSymbol>(INDEX_SYMBOLS);
+
+    // closest code symbol at or before address, like locate_name
+
+    auto it = std::upper_bound(symbols.first, symbols.second, address, [] (std::uint32_t l, IndexSymbol const& r) { return l < r.value; });
+
+    while (it != symbols.first)
+    {
+        --it;
+
+        if (!(it->flags & Symbol::FLAG_EXEC))
+            continue;
+
+        std::string result { index.name(*it) };
+
+        if (it->value != address)
+            result += "+$" + hex_string<2>(address - it->value);
+
+        return result;
+    }
+
+    return "$" + hex_string<4>(address);
+}
+
+static bool query(IndexView const& index, std::string_view where, std::ostream& output)
+{
+    IndexHeader const& header = index.header();
+
+    std::uint32_t address;
+
+    if (IndexSymbol const* symbol = index.find_symbol(where))
+        address = symbol->value;
+    else
+    {
+        try { address = hex_decode<std::uint32_t>(where); }
+        catch (HexDecodeError const&)
+        {
+            std::cerr << "No symbol named \"" << where << "\"" << std::endl;
+            return false;
+        }
+    }
+
+    output << "$" << hex_string<4>(address);
+
+    auto const symbols = index.symbols_at(address);
+
+    for (IndexSymbol const* it = symbols.first; it != symbols.second; ++it)
+        output << " " << index.name(*it);
+
+    output << std::endl;
+
+    if (address - header.base_address >= header.size)
+        output << "  outside" << std::endl;
+    else if (IndexBlock const* block = index.find_block(address))
+        output << "  code block $" << hex_string<4>(block->start) << "-$" << hex_string<4>(block->start + block->size - 1) << std::endl;
+    else
+        output << "  data" << std::endl;
+
+    auto const xrefs = index.xrefs_to(address);
+
+    for (IndexXref const* it = xrefs.first; it != xrefs.second; ++it)
+        output << "  " << xref_kind_name(it->kind) << " from $" << hex_string<4>(it->source) << " " << describe(index, it->source) << std::endl;
+
+    IndexLine const* const line = index.find_line(address);
+
+    if (line != nullptr && address - header.base_address < header.size)
+    {
+        std::string const listing_name { index.name(header.listing_name_offset, header.listing_name_size) };
+
+        output << "  listed at offset " << line->offset;
+
+        if (!listing_name.empty())
+        {
+            output << " of " << listing_name;
+
+            std::ifstream listing(listing_name);
+            std::string text;
+
+            if (listing.seekg(line->offset) && std::getline(listing, text))
+                output << ": " << text;
+        }
+
+        output << std::endl;
+    }
+
+    return true;
+}
+
+int query_main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "Usage: julian query INDEX WHERE..." << std::endl;
+        std::cerr << "WHERE is a symbol name or a hex address." << std::endl;
+
+        return 64;
+    }
+
+    try
+    {
+        IndexView const index(argv[1]);
+
+        bool ok = true;
+
+        for (int i = 2; i < argc; ++i)
+            ok = query(index, argv[i], std::cout) && ok;
+
+        return ok ? 0 : 1;
+    }
+    catch (IndexError const& e)
+    {
+        std::cerr << e.what() << std::endl;
+        std::cerr << std::endl;
+
+        return 3;
+    }
+}
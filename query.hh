@@ -0,0 +1,5 @@
+
+#pragma once
+
+// julian query INDEX WHERE...: answers lookups against an index written with --index
+int query_main(int argc, char** argv);
@@ -0,0 +1,349 @@
+
+#include "records.hh"
+
+#include "writer.hh"
+
+namespace
+{
+
+constexpr std::uint32_t NONE = 0xFFFFFFFF;
+constexpr std::uint32_t RECORDS_VERSION = 1;
+
+enum : std::uint8_t
+{
+    RECORD_SYMBOL = 1,
+    RECORD_LABEL  = 2,
+    RECORD_INSTR  = 3,
+    RECORD_DATA   = 4,
+};
+
+// indexed by Am
+char const* const MODE_NAMES[]
+{
+    "imp", "acc", "imm", "zrp", "zrx", "zry", "abs", "abx", "aby", "iab", "inx", "iny", "rel",
+};
+
+struct InstrRecord
+{
+    std::uint32_t address;
+    byte_type const* bytes;
+    std::uint8_t size;
+
+    OpInfo const* info;
+    std::uint16_t operand;
+
+    std::uint32_t symbol;
+    std::uint32_t target;
+};
+
+struct JsonlEncoder
+{
+    explicit JsonlEncoder(BufferedWriter& writer)
+        : m_writer(writer) {}
+
+    void begin() {}
+
+    void symbol(std::uint32_t index, Symbol const& symbol)
+    {
+        m_writer.write("{\"type\":\"symbol\",\"index\":");
+        m_writer.write_decimal(index);
+        m_writer.write(",\"name\":");
+        string(symbol.name);
+        m_writer.write(",\"value\":");
+        m_writer.write_decimal(symbol.value);
+        m_writer.write(",\"flags\":\"");
+
+        if (symbol.flags & Symbol::FLAG_READ)
+            m_writer.put('r');
+
+        if (symbol.flags & Symbol::FLAG_WRITE)
+            m_writer.put('w');
+
+        if (symbol.flags & Symbol::FLAG_EXEC)
+            m_writer.put('x');
+
+        m_writer.write("\"}\n");
+    }
+
+    void label(std::uint32_t address, std::string_view name, std::uint32_t symbol)
+    {
+        m_writer.write("{\"type\":\"label\",\"address\":");
+        m_writer.write_decimal(address);
+        m_writer.write(",\"name\":");
+        string(name);
+        optional(",\"symbol\":", symbol);
+        m_writer.write("}\n");
+    }
+
+    void instr(InstrRecord const& record)
+    {
+        m_writer.write("{\"type\":\"instr\",\"address\":");
+        m_writer.write_decimal(record.address);
+        m_writer.write(",\"bytes\":");
+        bytes(record.bytes, record.size);
+        m_writer.write(",\"mnemonic\":\"");
+        m_writer.write(record.info->name);
+        m_writer.write("\",\"mode\":\"");
+        m_writer.write(MODE_NAMES[static_cast<std::size_t>(record.info->addressing_mode)]);
+        m_writer.put('"');
+
+        if (record.size > 1)
+        {
+            m_writer.write(",\"operand\":");
+            m_writer.write_decimal(record.operand);
+        }
+
+        optional(",\"symbol\":", record.symbol);
+        optional(",\"target\":", record.target);
+        m_writer.write("}\n");
+    }
+
+    void data(std::uint32_t address, byte_type const* data, std::uint32_t size)
+    {
+        m_writer.write("{\"type\":\"data\",\"address\":");
+        m_writer.write_decimal(address);
+        m_writer.write(",\"bytes\":");
+        bytes(data, size);
+        m_writer.write("}\n");
+    }
+
+private:
+    void optional(std::string_view key, std::uint32_t value)
+    {
+        if (value == NONE)
+            return;
+
+        m_writer.write(key);
+        m_writer.write_decimal(value);
+    }
+
+    void bytes(byte_type const* data, std::size_t size)
+    {
+        m_writer.put('[');
+
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            if (i != 0)
+                m_writer.put(',');
+
+            m_writer.write_decimal(data[i]);
+        }
+
+        m_writer.put(']');
+    }
+
+    void string(std::string_view str)
+    {
+        static char const digits[] = "0123456789abcdef";
+
+        m_writer.put('"');
+
+        for (char chr : str)
+        {
+            unsigned char const uchr = chr;
+
+            if (chr == '"' || chr == '\\')
+            {
+                m_writer.put('\\');
+                m_writer.put(chr);
+            }
+            else if (uchr < 0x20)
+            {
+                m_writer.write("\\u00");
+                m_writer.put(digits[uchr >> 4]);
+                m_writer.put(digits[uchr & 0xF]);
+            }
+            else
+            {
+                m_writer.put(chr);
+            }
+        }
+
+        m_writer.put('"');
+    }
+
+    BufferedWriter& m_writer;
+};
+
+struct BinaryEncoder
+{
+    explicit BinaryEncoder(BufferedWriter& writer)
+        : m_writer(writer) {}
+
+    void begin()
+    {
+        m_writer.write(std::string_view("JULREC\0\0", 8));
+        m_writer.write_le(RECORDS_VERSION);
+    }
+
+    void symbol(std::uint32_t index, Symbol const& symbol)
+    {
+        header(RECORD_SYMBOL, 4 + 4 + 1 + string_size(symbol.name));
+
+        m_writer.write_le(index);
+        m_writer.write_le(symbol.value);
+        m_writer.write_le(symbol.flags);
+        string(symbol.name);
+    }
+
+    void label(std::uint32_t address, std::string_view name, std::uint32_t symbol)
+    {
+        header(RECORD_LABEL, 4 + 4 + string_size(name));
+
+        m_writer.write_le(address);
+        m_writer.write_le(symbol);
+        string(name);
+    }
+
+    void instr(InstrRecord const& record)
+    {
+        std::string_view const mnemonic { record.info->name };
+
+        header(RECORD_INSTR, 4 + 1 + record.size + 1 + 2 + 4 + 4 + string_size(mnemonic));
+
+        m_writer.write_le(record.address);
+        m_writer.write_le(record.size);
+        m_writer.write(reinterpret_cast<char const*>(record.bytes), record.size);
+        m_writer.write_le(static_cast<std::uint8_t>(record.info->addressing_mode));
+        m_writer.write_le(record.operand);
+        m_writer.write_le(record.symbol);
+        m_writer.write_le(record.target);
+        string(mnemonic);
+    }
+
+    void data(std::uint32_t address, byte_type const* data, std::uint32_t size)
+    {
+        header(RECORD_DATA, 4 + 4 + size);
+
+        m_writer.write_le(address);
+        m_writer.write_le(size);
+        m_writer.write(reinterpret_cast<char const*>(data), size);
+    }
+
+private:
+    void header(std::uint8_t type, std::uint32_t size)
+    {
+        m_writer.write_le(type);
+        m_writer.write_le(size);
+    }
+
+    static std::uint32_t string_size(std::string_view str)
+    {
+        return 2 + std::min<std::size_t>(str.size(), 0xFFFF);
+    }
+
+    void string(std::string_view str)
+    {
+        std::uint16_t const size = std::min<std::size_t>(str.size(), 0xFFFF);
+
+        m_writer.write_le(size);
+        m_writer.write(str.data(), size);
+    }
+
+    BufferedWriter& m_writer;
+};
+
+}
+
+template<typename Encoder>
+static void encode_records(Encoder& encoder, Analysis const& analysis)
+{
+    AnalConfig const& anal = analysis.anal;
+    DataBlock const& main_block = anal.main_block;
+    std::vector<Symbol> const& symbols = analysis.symbols;
+
+    encoder.begin();
+
+    for (std::size_t i = 0; i < symbols.size(); ++i)
+        encoder.symbol(i, symbols[i]);
+
+    AddressBlock const range { main_block.address, static_cast<std::uint32_t>(main_block.data.size()) };
+
+    for_each_print_item(range, analysis.blocks, symbols, [&] (auto const& item)
+    {
+        using T = std::decay_t<decltype(item)>;
+
+        if constexpr (std::is_same_v<T, PrintCode>)
+        {
+            for_each_instr(main_block.bytes(item), item, [&] (std::uint32_t addr, Instr const& instr)
+            {
+                OpInfo const* const info = anal.get_opcode_info(instr.opcode);
+                byte_type const* const bytes = main_block.data.data() + (addr - main_block.address);
+                std::uint32_t const size = get_instr_size(instr, anal);
+
+                // a label splitting an instruction leaves bytes that don't decode, or one going past the label
+                if (info == nullptr || addr + size > item.start + item.size)
+                {
+                    encoder.data(addr, bytes, std::min(size, item.start + item.size - addr));
+                    return;
+                }
+
+                InstrRecord record {};
+
+                record.address = addr;
+                record.bytes = bytes;
+                record.size = size;
+                record.info = info;
+                record.operand = instr.operand;
+                record.symbol = NONE;
+                record.target = NONE;
+
+                switch (info->addressing_mode)
+                {
+
+                case Am::IMP:
+                case Am::ACC:
+                case Am::IMM:
+                    break;
+
+                default:
+                    record.target = instr.operand;
+
+                    if (Symbol const* const symbol = find_operand_symbol(*info, instr, symbols))
+                        record.symbol = symbol - symbols.data();
+
+                    break;
+
+                }
+
+                encoder.instr(record);
+            });
+        }
+
+        if constexpr (std::is_same_v<T, PrintData>)
+        {
+            encoder.data(item.start, main_block.data.data() + (item.start - main_block.address), item.size);
+        }
+
+        if constexpr (std::is_same_v<T, Symbol>)
+        {
+            encoder.label(item.value, item.name, &item - symbols.data());
+        }
+    });
+}
+
+void write_records(RecordFormat format, Analysis const& analysis, std::ostream& output)
+{
+    BufferedWriter writer(output);
+
+    switch (format)
+    {
+
+    case RecordFormat::Jsonl:
+    {
+        JsonlEncoder encoder(writer);
+        encode_records(encoder, analysis);
+
+        break;
+    }
+
+    case RecordFormat::Binary:
+    {
+        BinaryEncoder encoder(writer);
+        encode_records(encoder, analysis);
+
+        break;
+    }
+
+    }
+}
@@ -0,0 +1,31 @@
+
+#pragma once
+
+#include "common.hh"
+#include "analyzer.hh"
+
+#include <ostream>
+
+// Machine-readable alternatives to the assembler listing. Both formats stream the same records, in order:
+//
+//   symbol  index, name, value, flags (one per merged symbol: other records refer to them by index)
+//   label   address, name, symbol index
+//   instr   address, bytes, mnemonic, addressing mode, operand, symbol index and target address (if any)
+//   data    address, bytes
+//
+// JSON Lines: one object per line, with a "type" field.
+//
+// Binary: "JULREC\0\0", u32 version, then records of u8 type, u32 payload size and payload. All integers are little
+// endian, absent symbol indices and targets are 0xFFFFFFFF, strings are a u16 size followed by the characters.
+//   symbol (1): u32 index, u32 value, u8 flags, str name
+//   label  (2): u32 address, u32 symbol, str name
+//   instr  (3): u32 address, u8 size, u8 bytes[size], u8 mode, u16 operand, u32 symbol, u32 target, str mnemonic
+//   data   (4): u32 address, u32 size, u8 bytes[size]
+
+enum struct RecordFormat
+{
+    Jsonl,
+    Binary,
+};
+
+void write_records(RecordFormat format, Analysis const& analysis, std::ostream& output);
@@ -0,0 +1,359 @@
+
+#include "synth.hh"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+
+struct Case
+{
+    char const* name;
+    SynthConfig config;
+
+    // output format (-F), nullptr for the listing
+    char const* format;
+};
+
+// 4 MB goes through bank mode, like any image bigger than the address space. The records cases have labels splitting
+// instructions, which come out as data.
+Case const CASES[]
+{
+    { "code-8k",          { 1, 0x2000, false }, nullptr },
+    { "code-32k",         { 2, 0x8000, false }, nullptr },
+    { "banked-256k",      { 3, 0x40000, false }, nullptr },
+    { "banked-1m",        { 4, 0x100000, false }, nullptr },
+    { "banked-4m",        { 5, 0x400000, false }, nullptr },
+    { "pathological-16k", { 6, 0x4000, true }, nullptr },
+    { "pathological-64k", { 7, 0x10000, true }, nullptr },
+    { "records-jsonl",    { 1, 0x8000, false }, "jsonl" },
+    { "records-binary",   { 1, 0x8000, false }, "binary" },
+};
+
+// runs that don't go over the baseline by this much are never regressions
+constexpr double MIN_SLOWDOWN_MS = 5.0;
+constexpr long MIN_GROWTH_KB = 1024;
+
+struct Measure
+{
+    double wall_ms;
+    long peak_rss_kb;
+    std::string output_hash;
+};
+
+struct RegressError : public std::runtime_error
+{
+    using std::runtime_error::runtime_error;
+};
+
+std::string hash_file(std::string const& name)
+{
+    std::ifstream input(name, std::ios::binary);
+
+    if (!input.is_open())
+        throw RegressError("Couldn't open file for read: " + name);
+
+    // FNV-1a
+    std::uint64_t hash = 0xCBF29CE484222325;
+    char buffer[0x10000];
+
+    while (input)
+    {
+        input.read(buffer, sizeof(buffer));
+
+        for (std::streamsize i = 0; i < input.gcount(); ++i)
+            hash = (hash ^ static_cast<unsigned char>(buffer[i])) * 0x100000001B3;
+    }
+
+    return hex_string<16>(hash);
+}
+
+Measure run_julian(std::string const& julian, std::vector<std::string> const& args, std::string const& output_file)
+{
+    std::vector<char*> argv;
+
+    argv.push_back(const_cast<char*>(julian.c_str()));
+
+    for (std::string const& arg : args)
+        argv.push_back(const_cast<char*>(arg.c_str()));
+
+    argv.push_back(const_cast<char*>("-o"));
+    argv.push_back(const_cast<char*>(output_file.c_str()));
+    argv.push_back(nullptr);
+
+    auto const start = std::chrono::steady_clock::now();
+
+    pid_t const pid = fork();
+
+    if (pid < 0)
+        throw RegressError("Couldn't fork");
+
+    if (pid == 0)
+    {
+        // the analysis log is of no interest
+        int const null = open("/dev/null", O_WRONLY);
+        dup2(null, STDERR_FILENO);
+
+        execv(argv[0], argv.data());
+        _exit(127);
+    }
+
+    int status;
+    struct rusage usage;
+
+    if (wait4(pid, &status, 0, &usage) < 0)
+        throw RegressError("Couldn't wait for julian");
+
+    auto const end = std::chrono::steady_clock::now();
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        throw RegressError("julian failed (status " + std::to_string(status) + ")");
+
+    return { std::chrono::duration<double, std::milli>(end - start).count(), usage.ru_maxrss, hash_file(output_file) };
+}
+
+// Baseline: one case per line, which is all it takes to read it back
+//   { "version": 1, "cases": [
+//     { "name": "code-8k", "wall_ms": 12.5, "peak_rss_kb": 4096, "output_hash": "0123456789ABCDEF" },
+//   ... ] }
+
+std::string_view json_value(std::string_view line, std::string_view key)
+{
+    std::string const quoted = "\"" + std::string(key) + "\":";
+    std::size_t start = line.find(quoted);
+
+    if (start == std::string_view::npos)
+        return {};
+
+    start = line.find_first_not_of(' ', start + quoted.size());
+
+    if (start == std::string_view::npos)
+        return {};
+
+    if (line[start] == '"')
+        return line.substr(start + 1, line.find('"', start + 1) - start - 1);
+
+    return line.substr(start, line.find_first_of(",}", start) - start);
+}
+
+std::map<std::string, Measure> read_baseline(std::istream& input)
+{
+    std::map<std::string, Measure> result;
+    std::string line;
+
+    while (std::getline(input, line))
+    {
+        std::string_view const name = json_value(line, "name");
+
+        if (name.empty())
+            continue;
+
+        Measure measure {};
+
+        measure.wall_ms = std::strtod(std::string(json_value(line, "wall_ms")).c_str(), nullptr);
+        measure.peak_rss_kb = std::strtol(std::string(json_value(line, "peak_rss_kb")).c_str(), nullptr, 10);
+        measure.output_hash = json_value(line, "output_hash");
+
+        result[std::string(name)] = measure;
+    }
+
+    return result;
+}
+
+void write_baseline(std::vector<std::pair<std::string, Measure>> const& measures, std::ostream& output)
+{
+    output << "{ \"version\": 1, \"cases\": [" << std::endl;
+
+    for (std::size_t i = 0; i < measures.size(); ++i)
+    {
+        auto const& [name, measure] = measures[i];
+
+        char wall[32];
+        std::snprintf(wall, sizeof(wall), "%.2f", measure.wall_ms);
+
+        output << "  { \"name\": \"" << name << "\", \"wall_ms\": " << wall << ", \"peak_rss_kb\": " << measure.peak_rss_kb
+            << ", \"output_hash\": \"" << measure.output_hash << "\" }" << (i + 1 < measures.size() ? "," : "") << std::endl;
+    }
+
+    output << "] }" << std::endl;
+}
+
+int usage()
+{
+    std::cerr << "Usage: julian-regress [-u] [-t PERCENT] [-r RUNS] JULIAN BASELINE" << std::endl;
+    std::cerr << "Runs JULIAN on a synthetic corpus and compares wall time, peak RSS and output hashes with BASELINE." << std::endl;
+    std::cerr << "  -u          write the results as the new baseline (done anyway if there is none)" << std::endl;
+    std::cerr << "  -t PERCENT  allowed slowdown and memory growth [default: 25]" << std::endl;
+    std::cerr << "  -r RUNS     runs per case, the fastest counts [default: 3]" << std::endl;
+
+    return 64;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    bool update = false;
+    double threshold = 25.0;
+    int runs = 3;
+
+    int option;
+
+    while ((option = getopt(argc, argv, "ut:r:")) != -1)
+    {
+        switch (option)
+        {
+
+        case 'u':
+            update = true;
+            break;
+
+        case 't':
+            threshold = std::strtod(optarg, nullptr);
+            break;
+
+        case 'r':
+            runs = std::max(1, std::atoi(optarg));
+            break;
+
+        default:
+            return usage();
+
+        }
+    }
+
+    if (argc - optind != 2)
+        return usage();
+
+    std::string const julian = std::filesystem::absolute(argv[optind]).string();
+    std::string const baseline_file = argv[optind + 1];
+
+    std::map<std::string, Measure> baseline;
+
+    {
+        std::ifstream input(baseline_file);
+
+        if (input.is_open())
+            baseline = read_baseline(input);
+        else
+            update = true;
+    }
+
+    char work_template[] = "/tmp/julian-regress-XXXXXX";
+
+    if (mkdtemp(work_template) == nullptr)
+    {
+        std::cerr << "Couldn't create a work directory" << std::endl;
+        return 3;
+    }
+
+    std::filesystem::path const work_dir = work_template;
+
+    std::vector<std::pair<std::string, Measure>> measures;
+    bool failed = false;
+
+    std::printf("%-20s %12s %12s %12s %12s  %s\n", "case", "wall ms", "baseline", "peak RSS KB", "baseline", "verdict");
+
+    try
+    {
+        for (Case const& c : CASES)
+        {
+            std::string const prefix = (work_dir / c.name).string();
+            std::vector<std::string> args = write_synth_rom(generate_rom(c.config), prefix);
+
+            if (c.format != nullptr)
+                args.insert(args.end(), { "-F", c.format });
+
+            Measure best {};
+
+            for (int i = 0; i < runs; ++i)
+            {
+                Measure const measure = run_julian(julian, args, prefix + ".asm");
+
+                if (i == 0 || measure.wall_ms < best.wall_ms)
+                    best.wall_ms = measure.wall_ms;
+
+                best.peak_rss_kb = std::max(best.peak_rss_kb, measure.peak_rss_kb);
+                best.output_hash = measure.output_hash;
+            }
+
+            measures.emplace_back(c.name, best);
+
+            auto const it = baseline.find(c.name);
+            std::string verdict = "new";
+
+            if (it != baseline.end())
+            {
+                Measure const& base = it->second;
+                double const factor = 1.0 + threshold / 100.0;
+
+                verdict.clear();
+
+                if (best.output_hash != base.output_hash)
+                    verdict += " output-changed";
+
+                if (best.wall_ms > base.wall_ms * factor && best.wall_ms - base.wall_ms > MIN_SLOWDOWN_MS)
+                    verdict += " slower";
+
+                if (best.peak_rss_kb > base.peak_rss_kb * factor && best.peak_rss_kb - base.peak_rss_kb > MIN_GROWTH_KB)
+                    verdict += " bigger";
+
+                failed = failed || !verdict.empty();
+
+                if (verdict.empty())
+                    verdict = "ok";
+                else
+                    verdict = "FAILED:" + verdict;
+            }
+
+            std::printf("%-20s %12.2f %12.2f %12ld %12ld  %s\n", c.name, best.wall_ms,
+                it != baseline.end() ? it->second.wall_ms : 0.0, best.peak_rss_kb,
+                it != baseline.end() ? it->second.peak_rss_kb : 0L, verdict.c_str());
+            std::fflush(stdout);
+
+            std::filesystem::remove(prefix + ".bin");
+            std::filesystem::remove(prefix + ".asm");
+        }
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << e.what() << std::endl;
+        std::filesystem::remove_all(work_dir);
+
+        return 3;
+    }
+
+    std::filesystem::remove_all(work_dir);
+
+    if (update)
+    {
+        std::ofstream output(baseline_file);
+
+        if (!output.is_open())
+        {
+            std::cerr << "Couldn't open file for write:" << std::endl;
+            std::cerr << "  " << baseline_file << std::endl;
+
+            return 3;
+        }
+
+        write_baseline(measures, output);
+        std::cout << "Wrote baseline " << baseline_file << std::endl;
+
+        return 0;
+    }
+
+    return failed ? 1 : 0;
+}
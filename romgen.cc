@@ -0,0 +1,57 @@
+
+#include "synth.hh"
+
+#include <iostream>
+#include <string_view>
+
+int main(int argc, char** argv)
+{
+    if (argc < 4 || argc > 5 || (argc == 5 && std::string_view(argv[4]) != "pathological"))
+    {
+        std::cerr << "Usage: julian-romgen SEED SIZE PREFIX [pathological]" << std::endl;
+        std::cerr << "SIZE is in hex bytes: up to 8000 makes a single image, more makes 4000 byte banks." << std::endl;
+
+        return 64;
+    }
+
+    SynthConfig config {};
+
+    try
+    {
+        config.seed = hex_decode<std::uint32_t>(argv[1]);
+        config.size = hex_decode<std::size_t>(argv[2]);
+    }
+    catch (HexDecodeError const& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 64;
+    }
+
+    config.pathological = argc == 5;
+
+    if (config.size < 0x400)
+    {
+        std::cerr << "SIZE must be at least 400" << std::endl;
+        return 64;
+    }
+
+    try
+    {
+        std::vector<std::string> const args = write_synth_rom(generate_rom(config), argv[3]);
+
+        // how to disassemble it
+        std::cout << "julian";
+
+        for (std::string const& arg : args)
+            std::cout << " " << arg;
+
+        std::cout << std::endl;
+    }
+    catch (SynthError const& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 3;
+    }
+
+    return 0;
+}
@@ -0,0 +1,340 @@
+
+#include "server.hh"
+
+#include <sstream>
+#include <system_error>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static std::string_view next_word(std::string_view& line)
+{
+    std::size_t const start = line.find_first_not_of(" \t\r");
+
+    if (start == std::string_view::npos)
+    {
+        line = {};
+        return {};
+    }
+
+    std::size_t const end = std::min(line.find_first_of(" \t\r", start), line.size());
+
+    std::string_view const result = line.substr(start, end - start);
+    line = line.substr(end);
+
+    return result;
+}
+
+bool Server::handle(std::string_view line, std::ostream& output)
+{
+    std::string_view const command = next_word(line);
+
+    try
+    {
+        if (command == "at")
+            at(resolve(next_word(line)), output);
+
+        else if (command == "xrefs")
+            xrefs(resolve(next_word(line)), output);
+
+        else if (command == "rename")
+        {
+            std::string_view const name = next_word(line);
+            rename(name, next_word(line));
+        }
+
+        else if (command == "print")
+            print(resolve(next_word(line)), output);
+
+        else if (command == "quit")
+        {
+            output << "." << std::endl;
+            return false;
+        }
+
+        else if (!command.empty())
+            throw ServerError("unknown request \"" + std::string { command } + "\"");
+    }
+    catch (ServerError const& e)
+    {
+        output << "error: " << e.what() << std::endl;
+    }
+
+    output << "." << std::endl;
+    return true;
+}
+
+std::uint32_t Server::resolve(std::string_view where) const
+{
+    if (where.empty())
+        throw ServerError("expected a symbol name or an address");
+
+    for (Symbol const& symbol : m_analysis.symbols)
+    {
+        if (symbol.name == where)
+            return symbol.value;
+    }
+
+    try { return hex_decode<std::uint32_t>(where); }
+    catch (HexDecodeError const&)
+    {
+        throw ServerError("no symbol named \"" + std::string { where } + "\"");
+    }
+}
+
+// the instruction covering `address` in the code block containing it, if any
+static std::optional<std::pair<std::uint32_t, Instr>> find_instr(Analysis const& analysis, std::uint32_t address)
+{
+    auto it = std::upper_bound(analysis.blocks.begin(), analysis.blocks.end(), AddressBlock { address, 0 });
+
+    if (it == analysis.blocks.begin() || !(--it)->contains(address))
+        return std::nullopt;
+
+    std::optional<std::pair<std::uint32_t, Instr>> result;
+
+    for_each_instr(analysis.anal.main_block.bytes(*it), *it, [&] (std::uint32_t addr, Instr const& instr)
+    {
+        if (address >= addr && address < addr + get_instr_size(instr, analysis.anal))
+            result = std::make_pair(addr, instr);
+    });
+
+    return result;
+}
+
+void Server::at(std::uint32_t address, std::ostream& output) const
+{
+    AnalConfig const& anal = m_analysis.anal;
+
+    output << "address $" << hex_string<4>(address) << std::endl;
+
+    auto const symbols = symbols_at(m_analysis.symbols, address);
+
+    for (auto it = symbols.first; it != symbols.second; ++it)
+    {
+        output << "symbol " << it->name << " "
+            << ((it->flags & Symbol::FLAG_READ) ? "r" : "")
+            << ((it->flags & Symbol::FLAG_WRITE) ? "w" : "")
+            << ((it->flags & Symbol::FLAG_EXEC) ? "x" : "") << std::endl;
+    }
+
+    if (!anal.main_block.contains(address))
+    {
+        output << "outside" << std::endl;
+        return;
+    }
+
+    output << "location " << locate_name(m_analysis.symbols, address) << std::endl;
+
+    auto const found = find_instr(m_analysis, address);
+
+    if (!found)
+    {
+        output << "data $" << hex_string<2>(anal.main_block.data[address - anal.main_block.address]) << std::endl;
+        return;
+    }
+
+    auto const& [addr, instr] = *found;
+
+    auto const first = anal.main_block.data.begin() + (addr - anal.main_block.address);
+    auto const last  = first + get_instr_size(instr, anal);
+
+    output << "code $" << hex_string<4>(addr) << " " << hex_string(first, last) << " "
+        << instr_to_string(instr, m_analysis.symbols) << std::endl;
+
+    if (m_analysis.profile && m_analysis.profile->executions[addr] != 0)
+        output << "executions " << m_analysis.profile->executions[addr] << std::endl;
+}
+
+void Server::xrefs(std::uint32_t address, std::ostream& output) const
+{
+    AnalConfig const& anal = m_analysis.anal;
+
+    for (Xref const& xref : m_analysis.xrefs.to(address))
+    {
+        SpanScanner bytes = anal.main_block.bytes({ xref.source, 3 });
+        Instr const instr = decode_instruction(xref.source, bytes);
+
+        output << "$" << hex_string<4>(xref.source) << " " << xref_kind_name(xref.kind) << " "
+            << locate_name(m_analysis.symbols, xref.source) << " " << instr_to_string(instr, m_analysis.symbols) << std::endl;
+    }
+}
+
+void Server::rename(std::string_view name, std::string_view new_name)
+{
+    if (name.empty() || new_name.empty())
+        throw ServerError("expected a symbol name and a new name");
+
+    for (Symbol const& symbol : m_analysis.symbols)
+    {
+        if (symbol.name == new_name)
+            throw ServerError("there already is a symbol named \"" + std::string { new_name } + "\"");
+    }
+
+    bool found = false;
+
+    auto const rename_in = [&] (std::vector<Symbol>& symbols)
+    {
+        for (Symbol& symbol : symbols)
+        {
+            if (symbol.name == name)
+            {
+                symbol.name = new_name;
+                found = true;
+            }
+        }
+    };
+
+    rename_in(m_analysis.symbols);
+    rename_in(m_analysis.new_symbols);
+
+    if (!found)
+        throw ServerError("no symbol named \"" + std::string { name } + "\"");
+}
+
+void Server::print(std::uint32_t address, std::ostream& output) const
+{
+    DataBlock const& main_block = m_analysis.anal.main_block;
+
+    if (!main_block.contains(address))
+        throw ServerError("$" + hex_string<4>(address) + " is outside of the input");
+
+    // the routine goes from the closest code label at or before the address to the next one
+
+    std::uint32_t start = main_block.address;
+    std::uint32_t end = main_block.address + main_block.data.size();
+
+    for (Symbol const& symbol : m_analysis.symbols)
+    {
+        if (!(symbol.flags & Symbol::FLAG_EXEC) || !main_block.contains(symbol.value))
+            continue;
+
+        if (symbol.value <= address)
+            start = symbol.value;
+        else
+        {
+            end = symbol.value;
+            break;
+        }
+    }
+
+    AddressBlock const range { start, end - start };
+    std::vector<AddressBlock> blocks;
+
+    for (AddressBlock const& block : m_analysis.blocks)
+    {
+        std::uint32_t const lo = std::max(block.start, range.start);
+        std::uint32_t const hi = std::min(block.start + block.size, range.start + range.size);
+
+        if (lo < hi)
+            blocks.push_back({ lo, hi - lo });
+    }
+
+    std::vector<PrintItem> const items = gen_print_items(range, blocks, m_analysis.symbols);
+    PrintExtras extras;
+    extras.profile = m_analysis.profile ? &*m_analysis.profile : nullptr;
+    extras.xrefs = &m_analysis.xrefs;
+    extras.fills = &m_analysis.anal.fill_blocks;
+
+    print_items(main_block, items, m_analysis.symbols, output, extras);
+}
+
+static void send_all(int fd, std::string const& data)
+{
+    std::size_t sent = 0;
+
+    while (sent < data.size())
+    {
+        ssize_t const count = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+
+        if (count <= 0)
+            return;
+
+        sent += count;
+    }
+}
+
+void serve(Server& server, std::string const& socket_path, Log const& log)
+{
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+
+    if (socket_path.size() >= sizeof(address.sun_path))
+        throw std::system_error(std::make_error_code(std::errc::filename_too_long), socket_path);
+
+    std::copy(socket_path.begin(), socket_path.end(), address.sun_path);
+
+    int const listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (listener < 0)
+        throw std::system_error(errno, std::generic_category(), "socket");
+
+    // a previous server may have left its socket behind, anything else is left alone
+    struct stat status;
+
+    if (::lstat(socket_path.c_str(), &status) == 0)
+    {
+        if (!S_ISSOCK(status.st_mode))
+        {
+            ::close(listener);
+            throw std::system_error(std::make_error_code(std::errc::file_exists), socket_path + " exists and is not a socket");
+        }
+
+        ::unlink(socket_path.c_str());
+    }
+
+    if (::bind(listener, reinterpret_cast<sockaddr const*>(&address), sizeof(address)) < 0 || ::listen(listener, 4) < 0)
+    {
+        int const error = errno;
+        ::close(listener);
+
+        throw std::system_error(error, std::generic_category(), socket_path);
+    }
+
+    log << "Listening on " << socket_path << std::endl;
+
+    bool running = true;
+
+    while (running)
+    {
+        int const client = ::accept(listener, nullptr, nullptr);
+
+        if (client < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+
+            // out of descriptors and the like, which trying again at once won't fix
+            log << "accept: " << std::generic_category().message(errno) << std::endl;
+            break;
+        }
+
+        std::string pending;
+        char buffer[0x1000];
+
+        while (running)
+        {
+            ssize_t const count = ::recv(client, buffer, sizeof(buffer), 0);
+
+            if (count <= 0)
+                break;
+
+            pending.append(buffer, count);
+
+            std::ostringstream responses;
+            std::size_t line_start = 0;
+
+            for (std::size_t newline; running && (newline = pending.find('\n', line_start)) != std::string::npos; line_start = newline + 1)
+                running = server.handle(std::string_view(pending).substr(line_start, newline - line_start), responses);
+
+            pending.erase(0, line_start);
+            send_all(client, responses.str());
+        }
+
+        ::close(client);
+    }
+
+    ::close(listener);
+    ::unlink(socket_path.c_str());
+}
@@ -0,0 +1,47 @@
+
+#pragma once
+
+#include "common.hh"
+#include "analyzer.hh"
+
+#include <ostream>
+#include <string_view>
+
+// Line protocol over an analysis kept in memory. Each request is one line, each response is any number of lines
+// followed by a line with a single ".". Failed requests answer a single "error: ..." line.
+//
+//   at <where>            what is at an address
+//   xrefs <where>         instructions referring to an address, and how
+//   rename <name> <new>   rename a symbol
+//   print <where>         listing of the routine containing an address
+//   quit                  stop the server
+//
+// <where> is a symbol name or a hex address.
+struct ServerError : public std::runtime_error
+{
+    using std::runtime_error::runtime_error;
+};
+
+struct Server
+{
+    explicit Server(Analysis& analysis)
+        : m_analysis(analysis) {}
+
+    // Returns false once asked to quit
+    bool handle(std::string_view line, std::ostream& output);
+
+private:
+    std::uint32_t resolve(std::string_view where) const;
+
+    void at(std::uint32_t address, std::ostream& output) const;
+    void xrefs(std::uint32_t address, std::ostream& output) const;
+    void rename(std::string_view name, std::string_view new_name);
+    void print(std::uint32_t address, std::ostream& output) const;
+
+    Analysis& m_analysis;
+};
+
+// Answers requests on a Unix domain socket at `socket_path`, one client at a time, until one asks to quit.
+// Throws std::system_error when the socket can't be set up, or something other than a socket is at `socket_path`. Stops
+// when accepting clients fails for good.
+void serve(Server& server, std::string const& socket_path, Log const& log);
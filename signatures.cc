@@ -0,0 +1,146 @@
+
+#include "signatures.hh"
+
+#include <queue>
+
+// longer anchors wouldn't be much more selective, and would take a lot more states
+constexpr std::uint32_t MAX_ANCHOR_SIZE = 16;
+
+SignatureMatcher::SignatureMatcher(std::vector<Signature> signatures)
+    : m_signatures(std::move(signatures))
+{
+    constexpr std::uint32_t NONE = UINT32_MAX;
+
+    std::array<std::uint32_t, 0x100> no_transitions;
+    no_transitions.fill(NONE);
+
+    m_next.push_back(no_transitions);
+    m_outputs.emplace_back();
+
+    // trie of the anchors
+
+    for (std::uint32_t i = 0; i < m_signatures.size(); ++i)
+    {
+        std::vector<std::int16_t> const& pattern = m_signatures[i].pattern;
+
+        Anchor anchor { 0, 0 };
+
+        for (std::uint32_t start = 0; start < pattern.size();)
+        {
+            std::uint32_t end = start;
+
+            while (end < pattern.size() && pattern[end] >= 0)
+                end++;
+
+            if (end - start > anchor.size)
+                anchor = { start, end - start };
+
+            start = end + 1;
+        }
+
+        anchor.size = std::min(anchor.size, MAX_ANCHOR_SIZE);
+        m_anchors.push_back(anchor);
+
+        std::uint32_t state = 0;
+
+        for (std::uint32_t j = anchor.offset; j < anchor.offset + anchor.size; ++j)
+        {
+            std::uint32_t& next = m_next[state][pattern[j]];
+
+            if (next == NONE)
+            {
+                next = m_next.size();
+
+                m_next.push_back(no_transitions);
+                m_outputs.emplace_back();
+            }
+
+            state = m_next[state][pattern[j]];
+        }
+
+        m_outputs[state].push_back(i);
+    }
+
+    // failure links, breadth first, turned into transitions
+
+    std::vector<std::uint32_t> fail(m_next.size(), 0);
+    std::queue<std::uint32_t> queue;
+
+    for (std::uint32_t& next : m_next[0])
+    {
+        if (next == NONE)
+            next = 0;
+        else
+            queue.push(next);
+    }
+
+    while (!queue.empty())
+    {
+        std::uint32_t const state = queue.front();
+        queue.pop();
+
+        for (std::uint32_t chr = 0; chr < 0x100; ++chr)
+        {
+            std::uint32_t const next = m_next[state][chr];
+
+            if (next == NONE)
+            {
+                m_next[state][chr] = m_next[fail[state]][chr];
+                continue;
+            }
+
+            fail[next] = m_next[fail[state]][chr];
+
+            std::vector<std::uint32_t> const& inherited = m_outputs[fail[next]];
+            m_outputs[next].insert(m_outputs[next].end(), inherited.begin(), inherited.end());
+
+            queue.push(next);
+        }
+    }
+}
+
+std::vector<SignatureMatch> SignatureMatcher::find_matches(DataBlock const& block) const
+{
+    std::vector<SignatureMatch> result;
+
+    if (m_signatures.empty())
+        return result;
+
+    std::size_t const size = block.data.size();
+    std::uint32_t state = 0;
+
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        state = m_next[state][block.data[i]];
+
+        for (std::uint32_t index : m_outputs[state])
+        {
+            Signature const& signature = m_signatures[index];
+            Anchor const& anchor = m_anchors[index];
+
+            // where the signature would start, the anchor ending at i
+            if (i + 1 < anchor.offset + anchor.size)
+                continue;
+
+            std::size_t const start = i + 1 - anchor.offset - anchor.size;
+
+            if (start + signature.pattern.size() > size)
+                continue;
+
+            bool matches = true;
+
+            for (std::size_t j = 0; j < signature.pattern.size() && matches; ++j)
+                matches = signature.pattern[j] < 0 || signature.pattern[j] == block.data[start + j];
+
+            if (matches)
+                result.push_back({ &signature, static_cast<std::uint32_t>(block.address + start) });
+        }
+    }
+
+    std::sort(result.begin(), result.end(), [] (SignatureMatch const& l, SignatureMatch const& r)
+    {
+        return l.address < r.address;
+    });
+
+    return result;
+}
@@ -0,0 +1,55 @@
+
+#pragma once
+
+#include "common.hh"
+#include "disasm.hh"
+
+#include <array>
+
+// A known routine: its bytes, where any byte goes for operands that depend on where it was assembled. At least one is
+// fixed.
+struct Signature
+{
+    std::string name;
+
+    // bytes to match, -1 for any
+    std::vector<std::int16_t> pattern;
+
+    // of the routine, from its first byte
+    std::uint32_t size;
+};
+
+struct SignatureMatch
+{
+    Signature const* signature;
+    std::uint32_t address;
+};
+
+// Matches many signatures in a single pass. An Aho-Corasick automaton looks for the longest run of fixed bytes of each
+// signature at once; the rest of a signature is only checked around where that run is found.
+struct SignatureMatcher
+{
+    SignatureMatcher() = default;
+    explicit SignatureMatcher(std::vector<Signature> signatures);
+
+    bool empty() const { return m_signatures.empty(); }
+    std::vector<Signature> const& signatures() const { return m_signatures; }
+
+    // sorted by address
+    std::vector<SignatureMatch> find_matches(DataBlock const& block) const;
+
+private:
+    // the run of fixed bytes of a signature the automaton looks for
+    struct Anchor
+    {
+        std::uint32_t offset;
+        std::uint32_t size;
+    };
+
+    std::vector<Signature> m_signatures;
+    std::vector<Anchor> m_anchors;
+
+    // transitions out of each state, and the signatures whose anchor ends at each state
+    std::vector<std::array<std::uint32_t, 0x100>> m_next;
+    std::vector<std::vector<std::uint32_t>> m_outputs;
+};
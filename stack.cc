@@ -0,0 +1,385 @@
+
+#include "stack.hh"
+
+#include <unordered_map>
+
+namespace
+{
+
+// anything deeper than this overflows the stack page anyway
+constexpr int MAX_DEPTH = 0x100;
+
+struct CallSite
+{
+    std::size_t callee;
+    int offset;
+};
+
+struct Routine
+{
+    std::uint32_t address;
+    int local_max;
+    bool unbounded;
+
+    std::vector<CallSite> calls;
+};
+
+struct CallGraph
+{
+    std::vector<Routine> routines;
+    std::unordered_map<std::uint32_t, std::size_t> by_address;
+
+    std::size_t get(std::uint32_t address)
+    {
+        auto const it = by_address.find(address);
+
+        if (it != by_address.end())
+            return it->second;
+
+        std::size_t const index = routines.size();
+
+        routines.push_back({ address, 0, false, {} });
+        by_address.emplace(address, index);
+
+        return index;
+    }
+};
+
+int get_stack_effect(Mnem mnemonic)
+{
+    switch (mnemonic)
+    {
+
+    case Mnem::PHA:
+    case Mnem::PHP:
+        return +1;
+
+    case Mnem::PLA:
+    case Mnem::PLP:
+        return -1;
+
+    default:
+        return 0;
+
+    }
+}
+
+}
+
+static std::vector<std::uint32_t> list_routine_entries(FlowGraph const& graph, std::vector<StackRoot> const& roots)
+{
+    std::vector<std::uint32_t> result;
+
+    for (FlowBlock const& block : graph.blocks)
+    {
+        if (block.last_info->flags & OpInfo::FLAG_CALL)
+            result.push_back(block.target);
+    }
+
+    for (StackRoot const& root : roots)
+        result.push_back(root.address);
+
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+
+    return result;
+}
+
+static CallGraph build_call_graph(AnalConfig const& anal, FlowGraph const& graph, std::vector<StackRoot> const& roots)
+{
+    CallGraph result;
+
+    std::vector<std::uint32_t> const entries = list_routine_entries(graph, roots);
+
+    for (StackRoot const& root : roots)
+        result.get(root.address);
+
+    // per-block entry depth (which may be negative: PLA before PHA, RTS tricks...), reset between routines through
+    // `touched`
+
+    std::vector<int> depths(graph.blocks.size(), 0);
+    std::vector<bool> visited(graph.blocks.size(), false);
+    std::vector<std::size_t> touched;
+    std::vector<std::size_t> worklist;
+
+    // routines are appended as calls to them are found
+
+    for (std::size_t i = 0; i < result.routines.size(); ++i)
+    {
+        std::uint32_t const address = result.routines[i].address;
+
+        int local_max = 0;
+        bool unbounded = false;
+        std::vector<CallSite> calls;
+
+        auto const enqueue = [&] (std::size_t block, int depth)
+        {
+            if (block == FlowGraph::NONE || (visited[block] && depths[block] >= depth))
+                return;
+
+            if (depth > MAX_DEPTH)
+            {
+                unbounded = true;
+                return;
+            }
+
+            if (!visited[block])
+            {
+                visited[block] = true;
+                touched.push_back(block);
+            }
+
+            depths[block] = depth;
+            worklist.push_back(block);
+        };
+
+        enqueue(graph.find(address), 0);
+
+        while (!worklist.empty())
+        {
+            FlowBlock const& block = graph.blocks[worklist.back()];
+            int depth = depths[worklist.back()];
+
+            worklist.pop_back();
+
+            for_each_flow_instr(anal, block, [&] ([[maybe_unused]] std::uint32_t addr, [[maybe_unused]] Instr const& instr, OpInfo const& info)
+            {
+                depth += get_stack_effect(info.mnemonic);
+                local_max = std::max(local_max, depth);
+            });
+
+            OpInfo const& info = *block.last_info;
+
+            if (info.flags & OpInfo::FLAG_CALL)
+            {
+                calls.push_back({ result.get(block.target), depth + 2 });
+                enqueue(block.next, depth);
+
+                continue;
+            }
+
+            if (info.mnemonic == Mnem::JMP && info.addressing_mode == Am::ABS
+                && block.target != address && in_sorted_vector(entries, block.target))
+            {
+                // tail call
+
+                calls.push_back({ result.get(block.target), depth });
+                continue;
+            }
+
+            enqueue(block.next, depth);
+            enqueue(block.jump, depth);
+        }
+
+        for (std::size_t block : touched)
+            visited[block] = false;
+
+        touched.clear();
+
+        Routine& routine = result.routines[i];
+
+        routine.local_max = local_max;
+        routine.unbounded = unbounded;
+        routine.calls = std::move(calls);
+    }
+
+    return result;
+}
+
+// Tarjan's algorithm, iterative. Components come out callees first.
+static std::vector<std::vector<std::size_t>> find_strongly_connected_components(CallGraph const& graph)
+{
+    std::size_t const count = graph.routines.size();
+    std::size_t const UNVISITED = SIZE_MAX;
+
+    std::vector<std::vector<std::size_t>> result;
+
+    std::vector<std::size_t> index(count, UNVISITED);
+    std::vector<std::size_t> lowlink(count, 0);
+    std::vector<bool> on_stack(count, false);
+
+    std::vector<std::size_t> stack;
+    std::vector<std::pair<std::size_t, std::size_t>> call_stack;
+
+    std::size_t next_index = 0;
+
+    for (std::size_t root = 0; root < count; ++root)
+    {
+        if (index[root] != UNVISITED)
+            continue;
+
+        call_stack.push_back({ root, 0 });
+
+        while (!call_stack.empty())
+        {
+            auto& [node, edge] = call_stack.back();
+
+            if (edge == 0)
+            {
+                index[node] = lowlink[node] = next_index++;
+                stack.push_back(node);
+                on_stack[node] = true;
+            }
+
+            std::vector<CallSite> const& calls = graph.routines[node].calls;
+
+            if (edge < calls.size())
+            {
+                std::size_t const callee = calls[edge++].callee;
+
+                if (index[callee] == UNVISITED)
+                    call_stack.push_back({ callee, 0 });
+                else if (on_stack[callee])
+                    lowlink[node] = std::min(lowlink[node], index[callee]);
+
+                continue;
+            }
+
+            // `edge` is past the end: node is done
+
+            std::size_t const done = node;
+
+            call_stack.pop_back();
+
+            if (!call_stack.empty())
+            {
+                std::size_t const parent = call_stack.back().first;
+                lowlink[parent] = std::min(lowlink[parent], lowlink[done]);
+            }
+
+            if (lowlink[done] == index[done])
+            {
+                std::vector<std::size_t> component;
+                std::size_t member;
+
+                do
+                {
+                    member = stack.back();
+                    stack.pop_back();
+                    on_stack[member] = false;
+                    component.push_back(member);
+                }
+                while (member != done);
+
+                result.push_back(std::move(component));
+            }
+        }
+    }
+
+    return result;
+}
+
+std::vector<StackDepth> analyse_stack_depth(AnalConfig const& anal, FlowGraph const& graph, std::vector<StackRoot> const& roots)
+{
+    CallGraph const calls = build_call_graph(anal, graph, roots);
+    std::size_t const count = calls.routines.size();
+
+    // Step 1. condense the call graph and compute depths callees first
+
+    std::vector<std::vector<std::size_t>> const components = find_strongly_connected_components(calls);
+    std::vector<std::size_t> component_of(count);
+
+    for (std::size_t i = 0; i < components.size(); ++i)
+    {
+        for (std::size_t member : components[i])
+            component_of[member] = i;
+    }
+
+    std::vector<int> best(count, 0);
+    std::vector<std::size_t> best_callee(count, SIZE_MAX);
+    std::vector<bool> recursive(count, false);
+    std::vector<bool> unbounded(count, false);
+
+    for (std::size_t c = 0; c < components.size(); ++c)
+    {
+        std::vector<std::size_t> const& component = components[c];
+
+        bool cyclic = component.size() > 1;
+
+        for (std::size_t member : component)
+        {
+            Routine const& routine = calls.routines[member];
+
+            best[member] = routine.local_max;
+            unbounded[member] = routine.unbounded;
+
+            for (CallSite const& call : routine.calls)
+            {
+                if (component_of[call.callee] == c)
+                {
+                    cyclic = true;
+                    continue;
+                }
+
+                int const depth = call.offset + best[call.callee];
+
+                if (depth > best[member])
+                {
+                    best[member] = depth;
+                    best_callee[member] = call.callee;
+                }
+
+                recursive[member] = recursive[member] || recursive[call.callee];
+                unbounded[member] = unbounded[member] || unbounded[call.callee];
+            }
+        }
+
+        if (!cyclic)
+            continue;
+
+        // Recursion: the true depth is unbounded. Go around the cycle once so
+        // that the reported depth is at least a meaningful lower bound.
+
+        for (std::size_t pass = 0; pass < component.size(); ++pass)
+        {
+            for (std::size_t member : component)
+            {
+                for (CallSite const& call : calls.routines[member].calls)
+                {
+                    if (component_of[call.callee] != c)
+                        continue;
+
+                    int const depth = std::min(call.offset + best[call.callee], MAX_DEPTH);
+
+                    if (depth > best[member])
+                    {
+                        best[member] = depth;
+                        best_callee[member] = call.callee;
+                    }
+                }
+            }
+        }
+
+        for (std::size_t member : component)
+            recursive[member] = true;
+    }
+
+    // Step 2. report from each root
+
+    std::vector<StackDepth> result;
+
+    for (StackRoot const& root : roots)
+    {
+        std::size_t const routine = calls.by_address.at(root.address);
+
+        StackDepth depth {};
+
+        depth.name = root.name;
+        depth.address = root.address;
+        depth.max_depth = root.base_depth + std::max(best[routine], 0);
+        depth.recursive = recursive[routine];
+        depth.unbounded = unbounded[routine];
+
+        std::vector<bool> visited(count, false);
+
+        for (std::size_t i = routine; i != SIZE_MAX && !visited[i]; i = best_callee[i])
+        {
+            visited[i] = true;
+            depth.path.push_back(calls.routines[i].address);
+        }
+
+        result.push_back(std::move(depth));
+    }
+
+    return result;
+}
@@ -0,0 +1,31 @@
+
+#pragma once
+
+#include "common.hh"
+#include "anal.hh"
+#include "flow.hh"
+
+struct StackRoot
+{
+    std::string name;
+    std::uint32_t address;
+
+    // bytes already on the stack on entry (3 for interrupt handlers)
+    unsigned base_depth;
+};
+
+struct StackDepth
+{
+    std::string name;
+    std::uint32_t address;
+
+    unsigned max_depth;
+
+    // routine entry addresses along the deepest call chain, starting at the root
+    std::vector<std::uint32_t> path;
+
+    bool recursive : 1;
+    bool unbounded : 1;
+};
+
+std::vector<StackDepth> analyse_stack_depth(AnalConfig const& anal, FlowGraph const& graph, std::vector<StackRoot> const& roots);
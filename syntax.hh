@@ -0,0 +1,206 @@
+
+#pragma once
+
+#include "common.hh"
+#include "6502.hh"
+
+#include <optional>
+#include <string_view>
+
+enum struct AsmSyntax : std::uint8_t
+{
+    Julian,
+    Ca65,
+    Asm6,
+    Nesasm,
+    Acme,
+};
+
+std::optional<AsmSyntax> parse_asm_syntax(std::string_view name);
+
+// Text around the operand of an instruction
+struct OperandTemplate
+{
+    char const* prefix;
+    char const* suffix;
+};
+
+// How to keep an absolute operand below $100 from being assembled as zero page (both empty: the assembler can't be told)
+struct ForceAbsolute
+{
+    char const* mnemonic_suffix;
+    char const* operand_prefix;
+};
+
+// Assembler syntaxes. Each is a set of tables the listing printer is specialized on at compile time:
+//   operands          decoration of each addressing mode (indexed by Am)
+//   force_absolute    see ForceAbsolute
+//   upper_mnemonics   print "LDA" rather than "lda"
+//   byte_directive    raw bytes
+//   fill_directive    count copies of a byte ("DIRECTIVE count, $XX"), nullptr: list them as raw bytes
+//   label_suffix      after label names
+//   line_comments     comments run to the end of the line (and go after instructions), rather than /* */ blocks
+namespace syntax
+{
+
+struct Julian
+{
+    static constexpr OperandTemplate operands[]
+    {
+        { "", "" },        // IMP
+        { " A", "" },      // ACC
+        { " #", "" },      // IMM
+        { " ", "" },       // ZRP
+        { " ", ", X" },    // ZRX
+        { " ", ", Y" },    // ZRY
+        { " ", "" },       // ABS
+        { " ", ", X" },    // ABX
+        { " ", ", Y" },    // ABY
+        { " (", ")" },     // IAB
+        { " (", ", X)" },  // INX
+        { " (", "), Y" },  // INY
+        { " ", "" },       // REL
+    };
+
+    static constexpr ForceAbsolute force_absolute { "", "" };
+    static constexpr bool upper_mnemonics = false;
+    static constexpr char const* byte_directive = ".db";
+    static constexpr char const* fill_directive = ".fill";
+    static constexpr char const* label_suffix = ":";
+    static constexpr bool line_comments = false;
+};
+
+struct Ca65
+{
+    static constexpr OperandTemplate operands[]
+    {
+        { "", "" },
+        { " a", "" },
+        { " #", "" },
+        { " ", "" },
+        { " ", ",x" },
+        { " ", ",y" },
+        { " ", "" },
+        { " ", ",x" },
+        { " ", ",y" },
+        { " (", ")" },
+        { " (", ",x)" },
+        { " (", "),y" },
+        { " ", "" },
+    };
+
+    static constexpr ForceAbsolute force_absolute { "", "a:" };
+    static constexpr bool upper_mnemonics = false;
+    static constexpr char const* byte_directive = ".byte";
+    static constexpr char const* fill_directive = ".res";
+    static constexpr char const* label_suffix = ":";
+    static constexpr bool line_comments = true;
+};
+
+struct Asm6
+{
+    static constexpr OperandTemplate operands[]
+    {
+        { "", "" },
+        { " a", "" },
+        { " #", "" },
+        { " ", "" },
+        { " ", ",x" },
+        { " ", ",y" },
+        { " ", "" },
+        { " ", ",x" },
+        { " ", ",y" },
+        { " (", ")" },
+        { " (", ",x)" },
+        { " (", "),y" },
+        { " ", "" },
+    };
+
+    static constexpr ForceAbsolute force_absolute { "", "" };
+    static constexpr bool upper_mnemonics = false;
+    static constexpr char const* byte_directive = ".db";
+    static constexpr char const* fill_directive = ".dsb";
+    static constexpr char const* label_suffix = ":";
+    static constexpr bool line_comments = true;
+};
+
+struct Nesasm
+{
+    static constexpr OperandTemplate operands[]
+    {
+        { "", "" },
+        { " A", "" },
+        { " #", "" },
+        { " ", "" },
+        { " ", ",X" },
+        { " ", ",Y" },
+        { " ", "" },
+        { " ", ",X" },
+        { " ", ",Y" },
+        { " [", "]" },
+        { " [", ",X]" },
+        { " [", "],Y" },
+        { " ", "" },
+    };
+
+    static constexpr ForceAbsolute force_absolute { "", "" };
+    static constexpr bool upper_mnemonics = true;
+    static constexpr char const* byte_directive = ".db";
+    static constexpr char const* fill_directive = nullptr;
+    static constexpr char const* label_suffix = ":";
+    static constexpr bool line_comments = true;
+};
+
+struct Acme
+{
+    static constexpr OperandTemplate operands[]
+    {
+        { "", "" },
+        { "", "" },
+        { " #", "" },
+        { " ", "" },
+        { " ", ",x" },
+        { " ", ",y" },
+        { " ", "" },
+        { " ", ",x" },
+        { " ", ",y" },
+        { " (", ")" },
+        { " (", ",x)" },
+        { " (", "),y" },
+        { " ", "" },
+    };
+
+    static constexpr ForceAbsolute force_absolute { "+2", "" };
+    static constexpr bool upper_mnemonics = false;
+    static constexpr char const* byte_directive = "!byte";
+    static constexpr char const* fill_directive = "!fill";
+    static constexpr char const* label_suffix = "";
+    static constexpr bool line_comments = true;
+};
+
+}
+
+// Calls func with a value of the syntax type, for it to be specialized on
+template<typename Func>
+decltype(auto) with_syntax(AsmSyntax which, Func&& func)
+{
+    switch (which)
+    {
+
+    case AsmSyntax::Ca65:
+        return func(syntax::Ca65 {});
+
+    case AsmSyntax::Asm6:
+        return func(syntax::Asm6 {});
+
+    case AsmSyntax::Nesasm:
+        return func(syntax::Nesasm {});
+
+    case AsmSyntax::Acme:
+        return func(syntax::Acme {});
+
+    default:
+        return func(syntax::Julian {});
+
+    }
+}
@@ -0,0 +1,385 @@
+
+#include "synth.hh"
+
+#include <fstream>
+#include <iterator>
+#include <optional>
+
+namespace
+{
+
+constexpr std::size_t BANK_SIZE = 0x4000;
+
+// bytes kept free for the largest region that isn't sized to fit (a routine)
+constexpr std::size_t REGION_ROOM = 0x100;
+
+// every Nth routine gets a symbol
+constexpr std::size_t NAMED_ROUTINE_PERIOD = 16;
+
+constexpr char const* WORDS[]
+{
+    "THE ", "PRESS ", "START", "GAME ", "OVER", "LEVEL ", "PLAYER ", "SCORE ", "TIME ", "WORLD ", "CONTINUE", "1UP ",
+};
+
+// single byte instructions that never end a block
+constexpr byte_type PLAIN_OPCODES[]
+{
+    0xEA, 0xE8, 0xC8, 0xCA, 0x88, 0x18, 0x38, 0xAA, 0xA8, 0x8A, 0x98, 0x0A, 0x4A,
+};
+
+struct Rng
+{
+    std::uint32_t state;
+
+    std::uint32_t next()
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+
+        return state;
+    }
+
+    std::uint32_t below(std::uint32_t bound)
+    {
+        return next() % bound;
+    }
+
+    std::uint32_t between(std::uint32_t low, std::uint32_t high)
+    {
+        return low + below(high - low + 1);
+    }
+};
+
+struct BankBuilder
+{
+    BankBuilder(Rng& rng, std::uint32_t address, std::size_t size, bool pathological, std::vector<std::uint32_t> const* external)
+        : m_rng(rng), m_address(address), m_size(size), m_pathological(pathological), m_external(external) {}
+
+    // vectors: the last 6 bytes point to the first three routines
+    std::vector<byte_type> build(bool vectors);
+
+    std::vector<std::uint32_t> const& routines() const { return m_routines; }
+
+private:
+    std::uint32_t here() const { return m_address + m_bytes.size(); }
+
+    void emit(std::initializer_list<byte_type> bytes) { m_bytes.insert(m_bytes.end(), bytes); }
+    void emit_word(std::uint32_t value) { emit({ byte_type(value), byte_type(value >> 8) }); }
+
+    std::optional<std::uint32_t> callee();
+
+    void routine();
+    void jump_table();
+    void text();
+    void tiles();
+    void padding(std::size_t size);
+    void slow_run();
+
+    Rng& m_rng;
+
+    std::uint32_t m_address;
+    std::size_t m_size;
+    bool m_pathological;
+
+    // routines of the fixed bank, if this one is switchable
+    std::vector<std::uint32_t> const* m_external;
+
+    std::vector<byte_type> m_bytes;
+    std::vector<std::uint32_t> m_routines;
+};
+
+std::optional<std::uint32_t> BankBuilder::callee()
+{
+    std::size_t const external = m_external ? m_external->size() : 0;
+    std::size_t const count = m_routines.size() + external;
+
+    if (count == 0)
+        return std::nullopt;
+
+    std::size_t const pick = m_rng.below(count);
+
+    return pick < m_routines.size() ? m_routines[pick] : (*m_external)[pick - m_routines.size()];
+}
+
+void BankBuilder::routine()
+{
+    m_routines.push_back(here());
+
+    std::vector<std::uint32_t> starts;
+    std::uint32_t const count = m_rng.between(4, 40);
+
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        starts.push_back(here());
+
+        byte_type const imm = m_rng.next();
+        byte_type const zp = m_rng.below(0x100);
+        std::uint32_t const ram = 0x200 + m_rng.below(0x600);
+
+        switch (m_rng.below(13))
+        {
+
+        case 0: emit({ 0xA9, imm }); break;                  // lda #imm
+        case 1: emit({ 0xA5, zp }); break;                   // lda zp
+        case 2: emit({ 0x85, zp }); break;                   // sta zp
+        case 3: emit({ 0xAD }); emit_word(ram); break;       // lda abs
+        case 4: emit({ 0x8D }); emit_word(ram); break;       // sta abs
+        case 5: emit({ 0xBD }); emit_word(ram); break;       // lda abs,x
+        case 6: emit({ 0x69, imm }); break;                  // adc #imm
+        case 7: emit({ PLAIN_OPCODES[m_rng.below(std::size(PLAIN_OPCODES))] }); break;
+        case 8: emit({ 0x8D }); emit_word(0x2000 + m_rng.below(8)); break; // sta PPU register
+        case 9: emit({ 0x2C, 0x02, 0x20 }); break;           // bit PPUSTATUS
+
+        case 10:
+        {
+            // branch back to an instruction of the routine in reach, or to the next one
+
+            static byte_type const branches[] { 0x10, 0x30, 0x90, 0xB0, 0xD0, 0xF0 };
+
+            std::uint32_t const target = starts[m_rng.below(starts.size())];
+            std::int32_t const offset = std::int32_t(target) - std::int32_t(here() + 2);
+
+            emit({ branches[m_rng.below(std::size(branches))], byte_type(offset >= -128 ? offset : 0) });
+            break;
+        }
+
+        default:
+            if (std::optional<std::uint32_t> const target = callee())
+            {
+                emit({ 0x20 }); // jsr
+                emit_word(*target);
+            }
+            else
+            {
+                emit({ 0xEA });
+            }
+
+            break;
+
+        }
+    }
+
+    std::uint32_t const end = m_rng.below(20);
+    std::optional<std::uint32_t> const tail = callee();
+
+    if (end < 3 && tail)
+    {
+        emit({ 0x4C }); // jmp
+        emit_word(*tail);
+    }
+    else
+    {
+        emit({ byte_type(end == 3 ? 0x40 : 0x60) }); // rti, rts
+    }
+}
+
+void BankBuilder::jump_table()
+{
+    std::uint32_t const count = m_rng.between(2, 8);
+    std::size_t const size = 15 + 2 * count;
+
+    if (m_routines.empty() || m_bytes.size() + size > m_size)
+        return;
+
+    m_routines.push_back(here());
+
+    std::uint32_t const table = here() + 15;
+
+    emit({ 0x0A, 0xA8 });                  // asl, tay
+    emit({ 0xB9 }); emit_word(table);      // lda table,y
+    emit({ 0x85, 0x00 });                  // sta $00
+    emit({ 0xB9 }); emit_word(table + 1);  // lda table+1,y
+    emit({ 0x85, 0x01 });                  // sta $01
+    emit({ 0x6C, 0x00, 0x00 });            // jmp ($0000)
+
+    for (std::uint32_t i = 0; i < count; ++i)
+        emit_word(*callee());
+}
+
+void BankBuilder::text()
+{
+    std::uint32_t const count = m_rng.between(3, 12);
+
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        for (char const* chr = WORDS[m_rng.below(std::size(WORDS))]; *chr != '\0'; ++chr)
+            m_bytes.push_back(*chr);
+    }
+
+    m_bytes.push_back(0);
+}
+
+void BankBuilder::tiles()
+{
+    std::uint32_t const count = m_rng.between(1, 8);
+
+    for (std::uint32_t i = 0; i < count * 16; ++i)
+    {
+        // sparse pixels, some solid rows
+        std::uint32_t const kind = m_rng.below(4);
+        m_bytes.push_back(kind == 0 ? 0xFF : kind == 1 ? 0x00 : byte_type(m_rng.next() & m_rng.next()));
+    }
+}
+
+void BankBuilder::padding(std::size_t size)
+{
+    m_bytes.insert(m_bytes.end(), size, m_rng.below(2) ? 0xFF : 0x00);
+}
+
+void BankBuilder::slow_run()
+{
+    // scanning from any byte of the run goes all the way to its end
+    std::uint32_t const size = m_rng.between(0x200, 0x1000);
+
+    for (std::uint32_t i = 0; i < size && m_bytes.size() + 1 < m_size; ++i)
+        m_bytes.push_back(PLAIN_OPCODES[m_rng.below(std::size(PLAIN_OPCODES))]);
+
+    m_bytes.push_back(0x02); // not an instruction
+}
+
+std::vector<byte_type> BankBuilder::build(bool vectors)
+{
+    std::size_t const usable = m_size - (vectors ? 6 : 0);
+
+    for (int i = 0; i < 3; ++i)
+        routine();
+
+    while (m_bytes.size() + REGION_ROOM < usable)
+    {
+        std::uint32_t const pick = m_rng.below(20);
+
+        if (pick < 10)
+            routine();
+        else if (pick < 12)
+            jump_table();
+        else if (pick < 14)
+            text();
+        else if (pick < 16)
+            tiles();
+        else if (pick < 18 || !m_pathological)
+            padding(m_rng.between(0x10, 0x100));
+        else if (usable - m_bytes.size() > 0x1000 + REGION_ROOM)
+            slow_run();
+    }
+
+    padding(usable - m_bytes.size());
+
+    if (vectors)
+    {
+        for (int i = 0; i < 3; ++i)
+            emit_word(m_routines[i]);
+    }
+
+    return std::move(m_bytes);
+}
+
+void add_named_routines(std::vector<std::uint32_t> const& routines, std::vector<Symbol>& symbols)
+{
+    for (std::size_t i = 0; i < routines.size(); i += NAMED_ROUTINE_PERIOD)
+        symbols.push_back({ "SUB_" + hex_string<4>(routines[i]), routines[i], Symbol::FLAG_EXEC });
+}
+
+}
+
+SynthRom generate_rom(SynthConfig const& config)
+{
+    SynthRom result {};
+    Rng rng { config.seed * 2654435761u + 1 };
+
+    result.segments.push_back({ { 0x0000, 0x0800 }, "RAM", Segment::FLAG_READ | Segment::FLAG_WRITE });
+    result.segments.push_back({ { 0x2000, 0x0008 }, "PPU", Segment::FLAG_READ | Segment::FLAG_WRITE | Segment::FLAG_VOLATILE });
+    result.segments.push_back({ { 0x4000, 0x0018 }, "IO", Segment::FLAG_READ | Segment::FLAG_WRITE | Segment::FLAG_VOLATILE });
+
+    result.symbols =
+    {
+        { "PPUCTRL",   0x2000, Symbol::FLAG_WRITE },
+        { "PPUMASK",   0x2001, Symbol::FLAG_WRITE },
+        { "PPUSTATUS", 0x2002, Symbol::FLAG_READ },
+        { "OAMADDR",   0x2003, Symbol::FLAG_WRITE },
+        { "PPUSCROLL", 0x2005, Symbol::FLAG_WRITE },
+        { "PPUADDR",   0x2006, Symbol::FLAG_WRITE },
+        { "PPUDATA",   0x2007, Symbol::FLAG_READ | Symbol::FLAG_WRITE },
+        { "OAMDMA",    0x4014, Symbol::FLAG_WRITE },
+        { "JOY1",      0x4016, Symbol::FLAG_READ | Symbol::FLAG_WRITE },
+    };
+
+    if (config.size <= 0x8000)
+    {
+        result.address = 0x10000 - config.size;
+        result.segments.push_back({ { result.address, std::uint32_t(config.size) }, "ROM", Segment::FLAG_READ | Segment::FLAG_EXEC });
+
+        BankBuilder builder(rng, result.address, config.size, config.pathological, nullptr);
+        result.image = builder.build(true);
+
+        add_named_routines(builder.routines(), result.symbols);
+
+        return result;
+    }
+
+    std::size_t const bank_count = config.size / BANK_SIZE;
+
+    result.address = 0x8000;
+    result.segments.push_back({ { 0x8000, 0x8000 }, "ROM", Segment::FLAG_READ | Segment::FLAG_EXEC });
+
+    // the fixed bank goes last, but comes first: the others call into it
+
+    BankBuilder fixed(rng, 0xC000, BANK_SIZE, config.pathological, nullptr);
+    std::vector<byte_type> const fixed_bytes = fixed.build(true);
+
+    add_named_routines(fixed.routines(), result.symbols);
+
+    for (std::size_t i = 0; i + 1 < bank_count; ++i)
+    {
+        BankBuilder builder(rng, 0x8000, BANK_SIZE, config.pathological, &fixed.routines());
+        std::vector<byte_type> const bytes = builder.build(false);
+
+        result.banks.push_back({ "BANK" + hex_string<2>(i), result.image.size(), BANK_SIZE, 0x8000, false });
+        result.image.insert(result.image.end(), bytes.begin(), bytes.end());
+    }
+
+    result.banks.push_back({ "FIXED", result.image.size(), BANK_SIZE, 0xC000, true });
+    result.image.insert(result.image.end(), fixed_bytes.begin(), fixed_bytes.end());
+
+    return result;
+}
+
+std::vector<std::string> write_synth_rom(SynthRom const& rom, std::string const& prefix)
+{
+    auto const write = [] (std::string const& name, auto do_write)
+    {
+        std::ofstream output(name, std::ios::binary);
+
+        if (!output.is_open())
+            throw SynthError("Couldn't open file for write: " + name);
+
+        do_write(output);
+
+        if (!output)
+            throw SynthError("Couldn't write file: " + name);
+    };
+
+    write(prefix + ".bin", [&] (std::ostream& output)
+    {
+        output.write(reinterpret_cast<char const*>(rom.image.data()), rom.image.size());
+    });
+
+    write(prefix + ".segments.csv", [&] (std::ostream& output) { write_segment_table(rom.segments, output); });
+    write(prefix + ".symbols.csv", [&] (std::ostream& output) { write_symbol_table(rom.symbols, output); });
+
+    std::vector<std::string> result;
+
+    if (rom.banks.empty())
+    {
+        result = { prefix + ".bin", hex_string<4>(rom.address) };
+    }
+    else
+    {
+        write(prefix + ".banks.csv", [&] (std::ostream& output) { write_bank_layout(rom.banks, output); });
+        result = { "-B", prefix + ".banks.csv", prefix + ".bin" };
+    }
+
+    result.insert(result.end(), { "-m", prefix + ".segments.csv", "-s", prefix + ".symbols.csv" });
+
+    return result;
+}
@@ -0,0 +1,44 @@
+
+#pragma once
+
+#include "common.hh"
+#include "tables.hh"
+
+struct SynthError : public std::runtime_error
+{
+    using std::runtime_error::runtime_error;
+};
+
+// Deterministic synthetic ROM images, for performance regression testing
+
+struct SynthConfig
+{
+    std::uint32_t seed;
+
+    // up to $8000: a single image ending at $FFFF; more: $4000 banks, the last fixed at $C000, the others at $8000
+    std::size_t size;
+
+    // add long runs of valid instructions ending on an invalid opcode, the worst case of the linear scan
+    bool pathological;
+};
+
+struct SynthRom
+{
+    std::vector<byte_type> image;
+
+    // mapping of a single image
+    std::uint32_t address;
+
+    // empty for single images
+    std::vector<BankLayout> banks;
+
+    std::vector<Segment> segments;
+    std::vector<Symbol> symbols;
+};
+
+// Subroutine graphs, jump tables, padding, text and tile data. Same config, same image.
+SynthRom generate_rom(SynthConfig const& config);
+
+// Writes PREFIX.bin, PREFIX.segments.csv, PREFIX.symbols.csv and, for banked images, PREFIX.banks.csv.
+// Returns the julian arguments disassembling them. Throws SynthError if a file can't be written.
+std::vector<std::string> write_synth_rom(SynthRom const& rom, std::string const& prefix);
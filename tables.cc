@@ -0,0 +1,223 @@
+
+#include "tables.hh"
+
+#include "csv.hh"
+
+std::vector<Segment> read_segment_table(std::istream& input)
+{
+    std::vector<Segment> result;
+
+    Csv csv = Csv::from_stream(input);
+
+    if (csv.field_names.size() != 4)
+        throw CsvError("Bad CSV column count. (Expected 4)");
+
+    for (Csv::Record const& record : csv.records)
+    {
+        Segment segment {};
+
+        segment.name = record[0];
+        segment.start = hex_decode<std::uint32_t>(record[1]);
+        segment.size = hex_decode<std::uint32_t>(record[2]);
+
+        for (char c : record[3])
+        {
+            switch (c)
+            {
+
+            case 'w':
+                segment.flags |= Segment::FLAG_WRITE;
+                break;
+
+            case 'r':
+                segment.flags |= Segment::FLAG_READ;
+                break;
+
+            case 'x':
+                segment.flags |= Segment::FLAG_EXEC;
+                break;
+
+            case 'v':
+                segment.flags |= Segment::FLAG_VOLATILE;
+                break;
+
+            default:
+                break;
+
+            }
+        }
+
+        result.push_back(std::move(segment));
+    }
+
+    return result;
+}
+
+std::vector<Symbol> read_symbol_table(std::istream& input)
+{
+    std::vector<Symbol> result;
+
+    Csv csv = Csv::from_stream(input);
+
+    if (csv.field_names.size() != 3)
+        throw CsvError("Bad CSV column count. (Expected 3)");
+
+    for (Csv::Record const& record : csv.records)
+    {
+        Symbol symbol {};
+
+        symbol.name = record[0];
+        symbol.value = hex_decode<std::uint32_t>(record[1]);
+
+        for (char c : record[2])
+        {
+            switch (c)
+            {
+
+            case 'w':
+                symbol.flags |= Symbol::FLAG_WRITE;
+                break;
+
+            case 'r':
+                symbol.flags |= Symbol::FLAG_READ;
+                break;
+
+            case 'x':
+                symbol.flags |= Symbol::FLAG_EXEC;
+                break;
+
+            default:
+                break;
+
+            }
+        }
+
+        result.push_back(std::move(symbol));
+    }
+
+    return result;
+}
+
+std::vector<BankLayout> read_bank_layout(std::istream& input)
+{
+    std::vector<BankLayout> result;
+
+    Csv csv = Csv::from_stream(input);
+
+    if (csv.field_names.size() != 5)
+        throw CsvError("Bad CSV column count. (Expected 5)");
+
+    for (Csv::Record const& record : csv.records)
+    {
+        BankLayout bank {};
+
+        bank.name = record[0];
+        bank.offset = hex_decode<std::size_t>(record[1]);
+        bank.size = hex_decode<std::size_t>(record[2]);
+        bank.address = hex_decode<std::uint32_t>(record[3]);
+        bank.fixed = record[4].find('f') != std::string::npos;
+
+        result.push_back(std::move(bank));
+    }
+
+    return result;
+}
+
+std::vector<Signature> read_signature_table(std::istream& input)
+{
+    std::vector<Signature> result;
+
+    Csv csv = Csv::from_stream(input);
+
+    if (csv.field_names.size() != 3)
+        throw CsvError("Bad CSV column count. (Expected 3)");
+
+    for (Csv::Record const& record : csv.records)
+    {
+        Signature signature {};
+
+        signature.name = record[0];
+
+        std::string_view pattern = record[1];
+
+        while (!pattern.empty())
+        {
+            std::size_t const end = pattern.find(' ');
+            std::string_view const token = pattern.substr(0, end);
+
+            pattern = (end == std::string_view::npos) ? std::string_view {} : pattern.substr(end + 1);
+
+            if (token.empty())
+                continue;
+
+            if (token == "??")
+                signature.pattern.push_back(-1);
+            else if (token.size() == 2)
+                signature.pattern.push_back(hex_decode<std::uint8_t>(token));
+            else
+                throw CsvError("Bad pattern byte \"" + std::string(token) + "\" in signature " + signature.name);
+        }
+
+        if (std::none_of(signature.pattern.begin(), signature.pattern.end(), [] (std::int16_t byte) { return byte >= 0; }))
+            throw CsvError("Signature " + signature.name + " has no fixed byte");
+
+        signature.size = (record[2] == "-") ? signature.pattern.size() : hex_decode<std::uint32_t>(record[2]);
+
+        result.push_back(std::move(signature));
+    }
+
+    return result;
+}
+
+// segment and symbol flags share their bits. The CSV reader doesn't take empty fields
+static std::string flags_field(std::uint8_t flags, bool volatile_flag = false)
+{
+    std::string result;
+
+    if (flags & Segment::FLAG_READ)
+        result.push_back('r');
+
+    if (flags & Segment::FLAG_WRITE)
+        result.push_back('w');
+
+    if (flags & Segment::FLAG_EXEC)
+        result.push_back('x');
+
+    if (volatile_flag && (flags & Segment::FLAG_VOLATILE))
+        result.push_back('v');
+
+    if (result.empty())
+        result.push_back('-');
+
+    return result;
+}
+
+void write_segment_table(std::vector<Segment> const& segments, std::ostream& output)
+{
+    output << "name,start,size,flags\n";
+
+    for (Segment const& segment : segments)
+    {
+        output << segment.name << "," << hex_string<4>(segment.start) << "," << hex_string<4>(segment.size)
+            << "," << flags_field(segment.flags, true) << "\n";
+    }
+}
+
+void write_symbol_table(std::vector<Symbol> const& symbols, std::ostream& output)
+{
+    output << "name,value,flags\n";
+
+    for (Symbol const& symbol : symbols)
+        output << symbol.name << "," << hex_string<4>(symbol.value) << "," << flags_field(symbol.flags) << "\n";
+}
+
+void write_bank_layout(std::vector<BankLayout> const& banks, std::ostream& output)
+{
+    output << "name,offset,size,address,flags\n";
+
+    for (BankLayout const& bank : banks)
+    {
+        output << bank.name << "," << hex_string<6>(bank.offset) << "," << hex_string<4>(bank.size)
+            << "," << hex_string<4>(bank.address) << "," << (bank.fixed ? "f" : "-") << "\n";
+    }
+}
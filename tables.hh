@@ -0,0 +1,40 @@
+
+#pragma once
+
+#include "common.hh"
+#include "anal.hh"
+#include "signatures.hh"
+
+#include <istream>
+#include <ostream>
+
+struct BankLayout
+{
+    std::string name;
+
+    // where the bank is in the input
+    std::size_t offset;
+    std::size_t size;
+
+    // where the bank is mapped
+    std::uint32_t address;
+
+    // always mapped, other banks can refer to it
+    bool fixed;
+};
+
+// All throw CsvError or HexDecodeError on bad input
+
+std::vector<Segment> read_segment_table(std::istream& input);
+std::vector<Symbol> read_symbol_table(std::istream& input);
+std::vector<BankLayout> read_bank_layout(std::istream& input);
+
+// name,pattern,size: pattern is hex bytes separated by spaces, ?? for any byte (at least one byte must be fixed). Size
+// is that of the routine, - for that of the pattern.
+std::vector<Signature> read_signature_table(std::istream& input);
+
+// In the format read back by the above
+
+void write_segment_table(std::vector<Segment> const& segments, std::ostream& output);
+void write_symbol_table(std::vector<Symbol> const& symbols, std::ostream& output);
+void write_bank_layout(std::vector<BankLayout> const& banks, std::ostream& output);
@@ -0,0 +1,91 @@
+
+#pragma once
+
+#include "common.hh"
+
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <ostream>
+#include <string_view>
+
+// Accumulates output in a fixed buffer and hands it to the stream in large chunks
+struct BufferedWriter
+{
+    explicit BufferedWriter(std::ostream& output)
+        : m_output(output) {}
+
+    ~BufferedWriter() { flush(); }
+
+    BufferedWriter(BufferedWriter const&) = delete;
+    BufferedWriter& operator = (BufferedWriter const&) = delete;
+
+    void flush()
+    {
+        m_output.write(m_buffer.data(), m_size);
+        m_size = 0;
+    }
+
+    void put(char chr)
+    {
+        if (m_size == m_buffer.size())
+            flush();
+
+        m_buffer[m_size++] = chr;
+    }
+
+    void write(char const* data, std::size_t size)
+    {
+        if (m_size + size > m_buffer.size())
+        {
+            flush();
+
+            if (size > m_buffer.size())
+            {
+                m_output.write(data, size);
+                return;
+            }
+        }
+
+        std::memcpy(m_buffer.data() + m_size, data, size);
+        m_size += size;
+    }
+
+    void write(std::string_view str)
+    {
+        write(str.data(), str.size());
+    }
+
+    template<typename IntType>
+    void write_decimal(IntType value)
+    {
+        reserve(24);
+
+        auto const [end, error] = std::to_chars(m_buffer.data() + m_size, m_buffer.data() + m_buffer.size(), value);
+        m_size = end - m_buffer.data();
+    }
+
+    // little endian
+    template<typename IntType>
+    void write_le(IntType value)
+    {
+        static_assert(std::is_integral_v<IntType>);
+
+        reserve(sizeof(IntType));
+
+        for (std::size_t i = 0; i < sizeof(IntType); ++i)
+            m_buffer[m_size++] = static_cast<char>((static_cast<std::uint64_t>(value) >> (i * 8)) & 0xFF);
+    }
+
+private:
+    void reserve(std::size_t size)
+    {
+        if (m_size + size > m_buffer.size())
+            flush();
+    }
+
+    std::ostream& m_output;
+
+    std::array<char, 0x10000> m_buffer;
+    std::size_t m_size = 0;
+};
@@ -0,0 +1,120 @@
+
+#include "xref.hh"
+
+char const* xref_kind_name(XrefKind kind)
+{
+    switch (kind)
+    {
+
+    case XrefKind::Call:
+        return "call";
+
+    case XrefKind::Jump:
+        return "jump";
+
+    case XrefKind::Branch:
+        return "branch";
+
+    case XrefKind::Read:
+        return "read";
+
+    case XrefKind::Write:
+        return "write";
+
+    case XrefKind::Indirect:
+        return "indirect";
+
+    }
+
+    return "?";
+}
+
+XrefIndex::Range XrefIndex::to(std::uint32_t target) const
+{
+    auto const it = std::lower_bound(targets.begin(), targets.end(), target);
+
+    if (it == targets.end() || *it != target)
+        return { nullptr, nullptr };
+
+    std::size_t const i = it - targets.begin();
+    return { refs.data() + offsets[i], refs.data() + offsets[i + 1] };
+}
+
+XrefIndex build_xref_index(AnalConfig const& anal, std::vector<AddressBlock> const& blocks)
+{
+    struct Edge
+    {
+        std::uint32_t target;
+        Xref xref;
+    };
+
+    std::vector<Edge> edges;
+
+    for (AddressBlock const& block : blocks)
+    {
+        for_each_instr(anal.main_block.bytes(block), block, [&] (std::uint32_t addr, Instr const& instr)
+        {
+            OpInfo const* const info = anal.get_opcode_info(instr.opcode);
+
+            XrefKind kind;
+
+            switch (info->addressing_mode)
+            {
+
+            case Am::IMP:
+            case Am::ACC:
+            case Am::IMM:
+                return;
+
+            case Am::REL:
+                kind = XrefKind::Branch;
+                break;
+
+            case Am::IAB:
+            case Am::INX:
+            case Am::INY:
+                kind = XrefKind::Indirect;
+                break;
+
+            default:
+                if (info->flags & OpInfo::FLAG_CALL)
+                    kind = XrefKind::Call;
+                else if (info->flags & OpInfo::FLAG_JUMP)
+                    kind = XrefKind::Jump;
+                else if (info->flags & OpInfo::FLAG_WRITE)
+                    kind = XrefKind::Write;
+                else
+                    kind = XrefKind::Read;
+
+                break;
+
+            }
+
+            edges.push_back({ instr.operand, { addr, kind } });
+        });
+    }
+
+    // blocks are sorted, so are sources within each target once sorted stably by target
+    std::stable_sort(edges.begin(), edges.end(), [] (Edge const& l, Edge const& r)
+    {
+        return l.target < r.target;
+    });
+
+    XrefIndex result;
+    result.refs.reserve(edges.size());
+
+    for (Edge const& edge : edges)
+    {
+        if (result.targets.empty() || result.targets.back() != edge.target)
+        {
+            result.targets.push_back(edge.target);
+            result.offsets.push_back(result.refs.size());
+        }
+
+        result.refs.push_back(edge.xref);
+    }
+
+    result.offsets.push_back(result.refs.size());
+
+    return result;
+}
@@ -0,0 +1,51 @@
+
+#pragma once
+
+#include "common.hh"
+#include "anal.hh"
+
+enum struct XrefKind : std::uint8_t
+{
+    Call,
+    Jump,
+    Branch,
+    Read,
+    Write,
+
+    // pointer used by JMP (ind), (zp,X) or (zp),Y
+    Indirect,
+};
+
+char const* xref_kind_name(XrefKind kind);
+
+struct Xref
+{
+    std::uint32_t source;
+    XrefKind kind;
+};
+
+// All references made by analysed code, grouped by target (compressed sparse row)
+struct XrefIndex
+{
+    struct Range
+    {
+        Xref const* first;
+        Xref const* last;
+
+        Xref const* begin() const { return first; }
+        Xref const* end() const { return last; }
+
+        std::size_t size() const { return last - first; }
+        bool empty() const { return first == last; }
+    };
+
+    // references to `target`, sorted by source
+    Range to(std::uint32_t target) const;
+
+    // referenced addresses (sorted), references to targets[i] are refs[offsets[i]] to refs[offsets[i+1]]
+    std::vector<std::uint32_t> targets;
+    std::vector<std::uint32_t> offsets;
+    std::vector<Xref> refs;
+};
+
+XrefIndex build_xref_index(AnalConfig const& anal, std::vector<AddressBlock> const& blocks);